@@ -0,0 +1,173 @@
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+#include "models.hpp"
+
+#include "aggregate.hpp"
+
+namespace Boinc
+{
+FleetAggregator::FleetAggregator()
+: dirty(false)
+, published(std::make_shared<const FleetTotals>())
+{
+}
+
+void
+FleetAggregator::apply(const Contribution& c, int sign)
+{
+  auto& count = this->project_results[c.project];
+  count += sign;
+  if (count == 0)
+  {
+    this->project_results.erase(c.project);
+    this->totals.cpu_time_remaining_by_project.erase(c.project);
+  }
+  else
+  {
+    this->totals.cpu_time_remaining_by_project[c.project] += sign * c.cpu_time_remaining;
+  }
+
+  auto state = static_cast<ResultState>(c.state);
+  auto& states = this->totals.results_by_state[state];
+  states += sign;
+  if (states == 0)
+  {
+    this->totals.results_by_state.erase(state);
+  }
+}
+
+void
+FleetAggregator::publish()
+{
+  std::atomic_store(&this->published, std::make_shared<const FleetTotals>(this->totals));
+}
+
+void
+FleetAggregator::update_results(const std::string& host, const std::vector<Result>& results)
+{
+  std::lock_guard<std::mutex> lock(this->ingest);
+
+  auto inserted = this->hosts.emplace(host, HostState());
+  auto& state = inserted.first->second;
+  bool changed = inserted.second;
+
+  std::unordered_map<std::string, Contribution> current;
+  current.reserve(results.size());
+  for (std::size_t i = 0; i < results.size(); i++)
+  {
+    auto& r = results[i];
+    Contribution c{r.project_url.value_or("").raw(), r.estimated_cpu_time_remaining.value_or(0), r.state.value_or(0)};
+    auto key = r.name ? c.project + '\n' + r.name->raw() : '#' + std::to_string(i);
+
+    auto previous = state.results.find(key);
+    if (previous == state.results.end())
+    {
+      this->apply(c, 1);
+      changed = true;
+    }
+    else
+    {
+      if (!(previous->second == c))
+      {
+        this->apply(previous->second, -1);
+        this->apply(c, 1);
+        changed = true;
+      }
+      state.results.erase(previous);
+    }
+    if (!current.emplace(std::move(key), c).second)
+    {
+      this->apply(c, -1);
+    }
+  }
+
+  for (auto& gone : state.results)
+  {
+    this->apply(gone.second, -1);
+    changed = true;
+  }
+  state.results.swap(current);
+
+  if (changed)
+  {
+    this->totals.hosts = this->hosts.size();
+    this->dirty = true;
+  }
+}
+
+void
+FleetAggregator::update_host_info(const std::string& host, const HostInfo& info)
+{
+  std::lock_guard<std::mutex> lock(this->ingest);
+
+  auto inserted = this->hosts.emplace(host, HostState());
+  auto& state = inserted.first->second;
+
+  auto p_fpops = info.p_fpops.value_or(0);
+  auto m_nbytes = info.m_nbytes.value_or(0);
+  if (!inserted.second && state.have_host_info && state.p_fpops == p_fpops && state.m_nbytes == m_nbytes)
+  {
+    return;
+  }
+
+  this->totals.p_fpops += p_fpops - state.p_fpops;
+  this->totals.m_nbytes += m_nbytes - state.m_nbytes;
+  state.p_fpops = p_fpops;
+  state.m_nbytes = m_nbytes;
+  state.have_host_info = true;
+
+  this->totals.hosts = this->hosts.size();
+  this->dirty = true;
+}
+
+void
+FleetAggregator::remove_host(const std::string& host)
+{
+  std::lock_guard<std::mutex> lock(this->ingest);
+
+  auto it = this->hosts.find(host);
+  if (it == this->hosts.end())
+  {
+    return;
+  }
+
+  for (auto& gone : it->second.results)
+  {
+    this->apply(gone.second, -1);
+  }
+  this->totals.p_fpops -= it->second.p_fpops;
+  this->totals.m_nbytes -= it->second.m_nbytes;
+  this->hosts.erase(it);
+  if (this->hosts.empty())
+  {
+    this->totals.p_fpops = 0;
+    this->totals.m_nbytes = 0;
+  }
+
+  this->totals.hosts = this->hosts.size();
+  this->dirty = true;
+}
+
+void
+FleetAggregator::commit()
+{
+  std::lock_guard<std::mutex> lock(this->ingest);
+  if (this->dirty)
+  {
+    this->publish();
+    this->dirty = false;
+  }
+}
+
+std::shared_ptr<const FleetTotals>
+FleetAggregator::snapshot() const
+{
+  return std::atomic_load(&this->published);
+}
+}
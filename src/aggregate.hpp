@@ -0,0 +1,71 @@
+#ifndef _AGGREGATE_HPP_
+#define _AGGREGATE_HPP_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "models.hpp"
+
+namespace Boinc
+{
+struct FleetTotals
+{
+  std::map<std::string, double> cpu_time_remaining_by_project;
+  std::map<ResultState, std::size_t> results_by_state;
+  double p_fpops = 0;
+  double m_nbytes = 0;
+  std::size_t hosts = 0;
+};
+
+// Fleet-wide rollups kept up to date from per-host snapshots. Each update compares
+// the snapshot with the previous one of the same host and applies only the entries
+// that changed. Readers get immutable snapshots and never wait for the ingest side;
+// updates become visible to them at the next commit(), which copies the totals once
+// per batch of updates rather than once per host.
+class FleetAggregator
+{
+public:
+  FleetAggregator();
+
+  void update_results(const std::string&, const std::vector<Result>&);
+  void update_host_info(const std::string&, const HostInfo&);
+  void remove_host(const std::string&);
+  void commit();
+
+  std::shared_ptr<const FleetTotals> snapshot() const;
+
+private:
+  struct Contribution
+  {
+    std::string project;
+    double cpu_time_remaining;
+    int state;
+
+    bool operator==(const Contribution& o) const { return this->cpu_time_remaining == o.cpu_time_remaining && this->state == o.state && this->project == o.project; }
+  };
+
+  struct HostState
+  {
+    std::unordered_map<std::string, Contribution> results;
+    double p_fpops = 0;
+    double m_nbytes = 0;
+    bool have_host_info = false;
+  };
+
+  void apply(const Contribution&, int);
+  void publish();
+
+  std::mutex ingest;
+  std::unordered_map<std::string, HostState> hosts;
+  std::unordered_map<std::string, std::size_t> project_results;
+  FleetTotals totals;
+  bool dirty;
+  std::shared_ptr<const FleetTotals> published;
+};
+}
+#endif
@@ -1,9 +1,21 @@
 #ifndef _BOINC_RPC_CPP_HPP_
 #define _BOINC_RPC_CPP_HPP_
 
+#include "aggregate.hpp"
+#include "capture.hpp"
 #include "client.hpp"
+#include "exception_list.hpp"
+#include "exporter.hpp"
+#include "fields.hpp"
+#include "history.hpp"
+#include "message_index.hpp"
 #include "models.hpp"
+#include "parse.hpp"
+#include "reply_budget.hpp"
 #include "rpc.hpp"
+#include "scheduler.hpp"
+#include "serialize.hpp"
 #include "util.hpp"
+#include "worker_pool.hpp"
 
 #endif
@@ -0,0 +1,54 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "client.hpp"
+#include "exporter.hpp"
+
+int
+main(int argc, char** argv)
+{
+  int port = 9640;
+  double interval = 30;
+  std::vector<Boinc::Client> clients;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc)
+    {
+      port = std::atoi(argv[++i]);
+      continue;
+    }
+    if (arg == "--interval" && i + 1 < argc)
+    {
+      interval = std::atof(argv[++i]);
+      continue;
+    }
+
+    // HOST:PORT[:PASSWORD]; the password is everything after the second colon.
+    auto first = arg.find(':');
+    if (first == std::string::npos || first == 0)
+    {
+      clients.clear();
+      break;
+    }
+    auto second = arg.find(':', first + 1);
+    Boinc::Client client;
+    client.addr = arg.substr(0, first);
+    client.port = std::atoi(arg.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1).c_str());
+    client.password = second == std::string::npos ? "" : arg.substr(second + 1);
+    clients.push_back(client);
+  }
+
+  if (clients.empty() || interval <= 0)
+  {
+    std::cerr << "usage: " << argv[0] << " [--port PORT] [--interval SECONDS] HOST:PORT[:PASSWORD]..." << std::endl;
+    return 2;
+  }
+
+  Boinc::MetricsExporter exporter(clients);
+  exporter.serve(port, interval);
+  return 0;
+}
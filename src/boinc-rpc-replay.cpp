@@ -0,0 +1,33 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "capture.hpp"
+
+int
+main(int argc, char** argv)
+{
+  if (argc >= 4 && std::string(argv[1]) == "--serve")
+  {
+    Boinc::serve_capture(Boinc::read_capture(argv[3]), std::atoi(argv[2]));
+    return 0;
+  }
+  if (argc < 2 || argc > 3)
+  {
+    std::cerr << "usage: " << argv[0] << " CAPTURE [ITERATIONS]" << std::endl;
+    std::cerr << "       " << argv[0] << " --serve PORT CAPTURE" << std::endl;
+    return 2;
+  }
+
+  auto iterations = argc == 3 ? std::atoi(argv[2]) : 1;
+  auto stats = Boinc::replay_capture(Boinc::read_capture(argv[1]), iterations);
+
+  std::cout << "replies: " << stats.replies << std::endl;
+  std::cout << "bytes: " << stats.bytes << std::endl;
+  std::cout << "entities: " << stats.entities << std::endl;
+  std::cout << "seconds: " << stats.seconds << std::endl;
+  std::cout << "MB/s: " << stats.mb_per_second() << std::endl;
+  std::cout << "entities/s: " << stats.entities_per_second() << std::endl;
+
+  return 0;
+}
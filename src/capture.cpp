@@ -0,0 +1,314 @@
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <glibmm.h>
+#include <libxml++/libxml++.h>
+
+#include "encoding.hpp"
+#include "exception_list.hpp"
+#include "models.hpp"
+#include "parse.hpp"
+#include "util.hpp"
+
+#include "capture.hpp"
+
+// File layout: "BOINCCAP" followed by one record per session:
+//   varint record size | i64 started_at (us) | varint port | varint host size | host |
+//   varint frame count | (u8 direction, varint size, bytes) per frame
+// A record cut short by a crash is ignored when reading.
+
+namespace Boinc
+{
+namespace
+{
+const char CAPTURE_MAGIC[8] = {'B', 'O', 'I', 'N', 'C', 'C', 'A', 'P'};
+
+std::shared_ptr<CaptureWriter> capture_writer;
+
+Glib::ustring
+request_command(const std::string& request)
+{
+  auto doc = load_xml(request);
+  for (auto n : doc->get_root_node()->get_children())
+  {
+    if (dynamic_cast<xmlpp::Element*>(n))
+    {
+      return n->get_name();
+    }
+  }
+  return "";
+}
+
+std::size_t
+parse_captured_reply(const Glib::ustring& command, const std::string& reply)
+{
+  if (command == "get_messages")
+  {
+    std::vector<Message> v;
+    decode_reply_entries(reply, "msgs", "msg", parse_message, v);
+    return v.size();
+  }
+  if (command == "get_results")
+  {
+    std::vector<Result> v;
+    decode_reply_entries(reply, "results", "result", parse_result, v);
+    return v.size();
+  }
+  if (command == "get_all_projects_list")
+  {
+    std::vector<ProjectInfo> v;
+    decode_reply_entries(reply, "projects", "project", parse_project, v);
+    return v.size();
+  }
+  if (command == "get_file_transfers")
+  {
+    std::vector<FileTransfer> v;
+    decode_reply_entries(reply, "file_transfers", "file_transfer", parse_file_transfer, v);
+    return v.size();
+  }
+
+  auto doc = load_reply(reply);
+  auto root_node = doc->get_root_node();
+  if (command == "get_host_info")
+  {
+    parse_host_info_reply(root_node);
+    return 1;
+  }
+  if (command == "acct_mgr_info")
+  {
+    parse_account_manager_info_reply(root_node);
+    return 1;
+  }
+  if (command == "acct_mgr_rpc_poll")
+  {
+    parse_account_manager_rpc_status_reply(root_node);
+    return 1;
+  }
+  if (command == "exchange_versions")
+  {
+    parse_version_info_reply(root_node);
+    return 1;
+  }
+  if (command == "get_cc_status")
+  {
+    parse_cc_status_reply(root_node);
+    return 1;
+  }
+  if (command == "get_disk_usage")
+  {
+    return parse_disk_usage_reply(root_node).projects.size();
+  }
+  return 0;
+}
+}
+
+CaptureWriter::CaptureWriter(const std::string& path)
+: out(path, std::ios::binary | std::ios::app)
+{
+  if (!this->out)
+  {
+    throw CaptureError(path);
+  }
+  if (this->out.tellp() == 0)
+  {
+    this->out.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    this->out.flush();
+  }
+}
+
+void
+CaptureWriter::write(const CaptureSession& session)
+{
+  std::string record;
+  put_uint(record, static_cast<std::uint64_t>(session.started_at), 8);
+  put_varint(record, session.port);
+  put_varint(record, session.host.size());
+  record += session.host;
+  put_varint(record, session.frames.size());
+  for (auto& frame : session.frames)
+  {
+    record += static_cast<char>(frame.direction == CaptureDirection::REQUEST ? 'Q' : 'R');
+    put_varint(record, frame.data.size());
+    record += frame.data;
+  }
+
+  std::string size;
+  put_varint(size, record.size());
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->out << size << record;
+  this->out.flush();
+  if (!this->out)
+  {
+    throw CaptureError("write failed");
+  }
+}
+
+void
+set_capture_writer(std::shared_ptr<CaptureWriter> writer)
+{
+  std::atomic_store(&capture_writer, writer);
+}
+
+std::shared_ptr<CaptureWriter>
+get_capture_writer()
+{
+  return std::atomic_load(&capture_writer);
+}
+
+std::vector<CaptureSession>
+read_capture(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+  {
+    throw CaptureError(path);
+  }
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(CAPTURE_MAGIC) || data.compare(0, sizeof(CAPTURE_MAGIC), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0)
+  {
+    throw CaptureError(Glib::ustring::compose("%1: not a capture file", path).raw());
+  }
+
+  std::vector<CaptureSession> sessions;
+  auto pos = reinterpret_cast<const unsigned char*>(data.data()) + sizeof(CAPTURE_MAGIC);
+  auto end = reinterpret_cast<const unsigned char*>(data.data()) + data.size();
+  while (pos != end)
+  {
+    std::uint64_t record_size;
+    if (!get_varint(pos, end, record_size) || static_cast<std::uint64_t>(end - pos) < record_size || record_size < 8)
+    {
+      break;
+    }
+    auto record_end = pos + record_size;
+
+    CaptureSession session;
+    session.started_at = static_cast<std::int64_t>(get_uint(pos, 8));
+    pos += 8;
+
+    std::uint64_t port, host_size, frame_count;
+    if (!get_varint(pos, record_end, port) || !get_varint(pos, record_end, host_size) || static_cast<std::uint64_t>(record_end - pos) < host_size)
+    {
+      throw CaptureError("corrupt session record");
+    }
+    session.port = port;
+    session.host.assign(reinterpret_cast<const char*>(pos), host_size);
+    pos += host_size;
+
+    if (!get_varint(pos, record_end, frame_count))
+    {
+      throw CaptureError("corrupt session record");
+    }
+    for (std::uint64_t i = 0; i < frame_count; i++)
+    {
+      std::uint64_t frame_size;
+      if (pos == record_end)
+      {
+        throw CaptureError("corrupt frame");
+      }
+      auto direction = *pos++;
+      if (!get_varint(pos, record_end, frame_size) || static_cast<std::uint64_t>(record_end - pos) < frame_size)
+      {
+        throw CaptureError("corrupt frame");
+      }
+      session.frames.push_back({direction == 'Q' ? CaptureDirection::REQUEST : CaptureDirection::REPLY, std::string(reinterpret_cast<const char*>(pos), frame_size)});
+      pos += frame_size;
+    }
+
+    sessions.push_back(std::move(session));
+    pos = record_end;
+  }
+  return sessions;
+}
+
+double
+ReplayStats::mb_per_second() const
+{
+  return this->seconds > 0 ? this->bytes / this->seconds / 1e6 : 0;
+}
+
+double
+ReplayStats::entities_per_second() const
+{
+  return this->seconds > 0 ? this->entities / this->seconds : 0;
+}
+
+ReplayStats
+replay_capture(const std::vector<CaptureSession>& sessions, int iterations)
+{
+  std::vector<std::pair<Glib::ustring, const std::string*>> replies;
+  for (auto& session : sessions)
+  {
+    Glib::ustring command;
+    for (auto& frame : session.frames)
+    {
+      if (frame.direction == CaptureDirection::REQUEST)
+      {
+        command = request_command(frame.data);
+      }
+      else if (!command.empty() && command != "auth1" && command != "auth2")
+      {
+        replies.emplace_back(command, &frame.data);
+      }
+    }
+  }
+
+  ReplayStats stats;
+  auto started = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+  {
+    for (auto& reply : replies)
+    {
+      stats.entities += parse_captured_reply(reply.first, *reply.second);
+      stats.bytes += reply.second->size();
+      stats.replies++;
+    }
+  }
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  return stats;
+}
+
+void
+serve_capture(const std::vector<CaptureSession>& sessions, int port, int connections)
+{
+  if (sessions.empty())
+  {
+    throw CaptureError("no sessions to serve");
+  }
+
+  boost::asio::io_service ios;
+  boost::asio::ip::tcp::acceptor acceptor(ios, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+
+  for (int n = 0; connections == 0 || n < connections; n++)
+  {
+    boost::asio::ip::tcp::socket socket(ios);
+    acceptor.accept(socket);
+
+    try
+    {
+      for (auto& frame : sessions[n % sessions.size()].frames)
+      {
+        if (frame.direction == CaptureDirection::REQUEST)
+        {
+          boost::asio::streambuf buf;
+          boost::asio::read_until(socket, buf, '\3');
+        }
+        else
+        {
+          boost::asio::write(socket, boost::asio::buffer(frame.data));
+          boost::asio::write(socket, boost::asio::buffer("\3", 1));
+        }
+      }
+    }
+    catch (const boost::system::system_error& e)
+    {
+    }
+  }
+}
+}
@@ -0,0 +1,71 @@
+#ifndef _CAPTURE_HPP_
+#define _CAPTURE_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Boinc
+{
+enum class CaptureDirection
+{
+  REQUEST,
+  REPLY
+};
+
+struct CaptureFrame
+{
+  CaptureDirection direction;
+  std::string data;
+};
+
+// One query_boinc_daemon() call: every framed request and reply in wire order, without the '\3' terminators.
+// The nonce_hash of auth2 requests is replaced with "redacted".
+struct CaptureSession
+{
+  std::string host;
+  int port;
+  std::int64_t started_at;
+  std::vector<CaptureFrame> frames;
+};
+
+class CaptureWriter
+{
+public:
+  explicit CaptureWriter(const std::string&);
+
+  void write(const CaptureSession&);
+
+private:
+  std::mutex mutex;
+  std::ofstream out;
+};
+
+// Recording is off until a writer is installed; pass nullptr to stop.
+void set_capture_writer(std::shared_ptr<CaptureWriter>);
+std::shared_ptr<CaptureWriter> get_capture_writer();
+
+std::vector<CaptureSession> read_capture(const std::string&);
+
+struct ReplayStats
+{
+  std::size_t replies = 0;
+  std::size_t bytes = 0;
+  std::size_t entities = 0;
+  double seconds = 0;
+
+  double mb_per_second() const;
+  double entities_per_second() const;
+};
+
+// Feeds recorded replies through load_reply() and the parsers of the request that produced them.
+ReplayStats replay_capture(const std::vector<CaptureSession>&, int = 1);
+
+// Acts as a daemon on 127.0.0.1, answering each connection with the next recorded session.
+// Serves forever when the connection limit is 0.
+void serve_capture(const std::vector<CaptureSession>&, int, int = 0);
+}
+#endif
@@ -1,12 +1,14 @@
 #ifndef _CLIENT_HPP_
 #define _CLIENT_HPP_
 
+#include <functional>
 #include <vector>
 #include <string>
 
 #include <glibmm.h>
 
 #include "models.hpp"
+#include "scheduler.hpp"
 
 namespace Boinc
 {
@@ -17,15 +19,22 @@ struct Client
   std::string password;
 
   std::vector<Message> get_messages(int = 0);
+  void for_each_message(std::function<void(Message&)>, int = 0);
   std::vector<ProjectInfo> get_projects();
   AccountManagerInfo get_account_manager_info();
   int get_account_manager_rpc_status();
   void account_manager_rpc(Glib::ustring, Glib::ustring, Glib::ustring);
   VersionInfo exchange_versions(VersionInfo);
   std::vector<Result> get_results(bool = false);
+  void for_each_result(std::function<void(Result&)>, bool = false);
   void set_mode(Component, RunMode, double = 0);
   HostInfo get_host_info();
   void set_language(Glib::ustring);
+  CcStatus get_cc_status(RequestPriority = RequestPriority::BULK);
+  std::vector<FileTransfer> get_file_transfers();
+  DiskUsage get_disk_usage();
+  // Runs get_cc_status() as INTERACTIVE by default so that latency is not mostly time spent queued behind bulk reads.
+  ProbeResult probe(RequestPriority = RequestPriority::INTERACTIVE);
 };
 }
 #endif
@@ -0,0 +1,70 @@
+#ifndef _ENCODING_HPP_
+#define _ENCODING_HPP_
+
+#include <cstdint>
+#include <string>
+
+// Little-endian and varint helpers shared by the binary file formats.
+
+namespace Boinc
+{
+inline void
+put_uint(std::string& out, std::uint64_t v, int bytes)
+{
+  for (int i = 0; i < bytes; i++)
+  {
+    out += static_cast<char>((v >> (8 * i)) & 0xff);
+  }
+}
+
+inline std::uint64_t
+get_uint(const unsigned char* p, int bytes)
+{
+  std::uint64_t v = 0;
+  for (int i = 0; i < bytes; i++)
+  {
+    v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+  }
+  return v;
+}
+
+inline void
+put_varint(std::string& out, std::uint64_t v)
+{
+  while (v >= 0x80)
+  {
+    out += static_cast<char>((v & 0x7f) | 0x80);
+    v >>= 7;
+  }
+  out += static_cast<char>(v);
+}
+
+inline bool
+get_varint(const unsigned char*& pos, const unsigned char* end, std::uint64_t& v)
+{
+  v = 0;
+  for (int shift = 0; shift < 64 && pos != end; shift += 7)
+  {
+    auto b = *pos++;
+    v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline std::uint64_t
+zigzag(std::int64_t v)
+{
+  return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t
+unzigzag(std::uint64_t v)
+{
+  return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+}
+#endif
@@ -14,5 +14,8 @@ DEFINE_EXCEPTION(NetworkError, "network error occurred");
 DEFINE_EXCEPTION(AuthError, "auth error occurred");
 DEFINE_EXCEPTION(InvalidURLError, "invalid URL");
 DEFINE_EXCEPTION(AlreadyAttachedError, "already attached");
+DEFINE_EXCEPTION(HistoryError, "history storage error");
+DEFINE_EXCEPTION(CaptureError, "capture file error");
+DEFINE_EXCEPTION(ReplyTooLargeError, "reply exceeds memory budget");
 }
 #endif
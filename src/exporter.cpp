@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <future>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <glibmm.h>
+
+#include "client.hpp"
+#include "models.hpp"
+#include "serialize.hpp"
+#include "worker_pool.hpp"
+
+#include "exporter.hpp"
+
+namespace Boinc
+{
+namespace
+{
+enum Family
+{
+  UP,
+  RPC_LATENCY,
+  TASK_SUSPEND_REASON,
+  RESULTS,
+  CPU_TIME_REMAINING,
+  FILE_TRANSFERS,
+  DISK_USAGE,
+  FAMILY_COUNT
+};
+
+const char* const FAMILY_NAMES[FAMILY_COUNT] = {
+  "boinc_up",
+  "boinc_rpc_latency_seconds",
+  "boinc_task_suspend_reason",
+  "boinc_results",
+  "boinc_cpu_time_remaining_seconds",
+  "boinc_file_transfers",
+  "boinc_disk_usage_bytes",
+};
+
+const char* const FAMILY_HELP[FAMILY_COUNT] = {
+  "Whether the last poll of the daemon succeeded.",
+  "Round-trip time of the last get_cc_status call.",
+  "Reasons computation is suspended, 0 when not suspended.",
+  "Tasks on the host by result state.",
+  "Estimated CPU time remaining by project.",
+  "Pending file transfers by direction.",
+  "Disk space used by project.",
+};
+
+std::string
+label_value(const std::string& v)
+{
+  std::string out;
+  out.reserve(v.size());
+  for (auto c : v)
+  {
+    if (c == '\\' || c == '"')
+    {
+      out += '\\';
+      out += c;
+    }
+    else if (c == '\n')
+    {
+      out += "\\n";
+    }
+    else
+    {
+      out += c;
+    }
+  }
+  return out;
+}
+
+void
+put_value(std::string& out, double v)
+{
+  if (std::isnan(v))
+  {
+    out += "NaN";
+    return;
+  }
+  if (std::isinf(v))
+  {
+    out += v > 0 ? "+Inf" : "-Inf";
+    return;
+  }
+
+  char tmp[32];
+  out.append(tmp, format_real(v, tmp));
+}
+
+const int SCRAPE_TIMEOUT = 10;
+
+// One scrape. The deadline closes the socket if the request or the response stalls,
+// which also completes whichever operation is still pending.
+struct ScrapeConnection : std::enable_shared_from_this<ScrapeConnection>
+{
+  boost::asio::ip::tcp::socket socket;
+  boost::asio::deadline_timer deadline;
+  boost::asio::streambuf request;
+  std::string response;
+  const MetricsExporter& exporter;
+
+  ScrapeConnection(boost::asio::io_service& ios, const MetricsExporter& exporter)
+  : socket(ios)
+  , deadline(ios)
+  , request(8192)
+  , exporter(exporter)
+  {
+  }
+
+  void start()
+  {
+    auto self = this->shared_from_this();
+    this->deadline.expires_from_now(boost::posix_time::seconds(SCRAPE_TIMEOUT));
+    this->deadline.async_wait([self](const boost::system::error_code& ec) {
+      if (!ec)
+      {
+        boost::system::error_code ignored;
+        self->socket.close(ignored);
+      }
+    });
+    boost::asio::async_read_until(this->socket, this->request, "\r\n\r\n", [self](const boost::system::error_code& ec, std::size_t) {
+      if (!ec)
+      {
+        self->respond();
+      }
+    });
+  }
+
+  void respond()
+  {
+    std::istream in(&this->request);
+    std::string method, path;
+    in >> method >> path;
+
+    if (method == "GET" && (path == "/metrics" || path.compare(0, 9, "/metrics?") == 0))
+    {
+      auto body = this->exporter.render();
+      this->response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+      this->response += body;
+    }
+    else
+    {
+      this->response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    auto self = this->shared_from_this();
+    boost::asio::async_write(this->socket, boost::asio::buffer(this->response), [self](const boost::system::error_code&, std::size_t) {
+      boost::system::error_code ignored;
+      self->deadline.cancel(ignored);
+      self->socket.close(ignored);
+    });
+  }
+};
+
+void
+accept_scrape(boost::asio::io_service& ios, boost::asio::ip::tcp::acceptor& acceptor, const MetricsExporter& exporter)
+{
+  auto connection = std::make_shared<ScrapeConnection>(ios, exporter);
+  acceptor.async_accept(connection->socket, [&ios, &acceptor, &exporter, connection](const boost::system::error_code& ec) {
+    if (!ec)
+    {
+      connection->start();
+    }
+    accept_scrape(ios, acceptor, exporter);
+  });
+}
+}
+
+MetricsExporter::MetricsExporter(std::vector<Client> clients)
+{
+  for (auto& client : clients)
+  {
+    std::unique_ptr<HostMetrics> h(new HostMetrics);
+    h->label = label_value(client.addr + ':' + std::to_string(client.port));
+    h->client = std::move(client);
+    h->samples.resize(FAMILY_COUNT);
+    h->fragments.resize(FAMILY_COUNT);
+    this->hosts.push_back(std::move(h));
+  }
+}
+
+void
+MetricsExporter::update(HostMetrics& h, std::size_t family, Samples& samples)
+{
+  if (samples == h.samples[family] && h.fragments[family])
+  {
+    return;
+  }
+
+  auto fragment = std::make_shared<std::string>();
+  for (auto& s : samples)
+  {
+    *fragment += FAMILY_NAMES[family];
+    *fragment += "{host=\"";
+    *fragment += h.label;
+    *fragment += '"';
+    if (!s.first.empty())
+    {
+      *fragment += ',';
+      *fragment += s.first;
+    }
+    *fragment += "} ";
+    put_value(*fragment, s.second);
+    *fragment += '\n';
+  }
+
+  h.samples[family] = std::move(samples);
+  std::lock_guard<std::mutex> lock(this->mutex);
+  h.fragments[family] = std::move(fragment);
+}
+
+void
+MetricsExporter::poll_host(std::size_t i)
+{
+  auto& h = *this->hosts.at(i);
+  std::vector<Samples> next(FAMILY_COUNT);
+
+  auto probe = h.client.probe();
+  if (probe.reachable)
+  {
+    try
+    {
+      next[RPC_LATENCY].emplace_back("", probe.latency);
+      next[TASK_SUSPEND_REASON].emplace_back("", probe.status.task_suspend_reason.value_or(0));
+
+      std::map<int, double> states;
+      std::map<std::string, double> remaining;
+      for (auto& r : h.client.get_results())
+      {
+        states[r.state.value_or(0)]++;
+        remaining[r.project_url.value_or("").raw()] += r.estimated_cpu_time_remaining.value_or(0);
+      }
+      for (auto& s : states)
+      {
+        next[RESULTS].emplace_back("state=\"" + std::to_string(s.first) + '"', s.second);
+      }
+      for (auto& p : remaining)
+      {
+        next[CPU_TIME_REMAINING].emplace_back("project=\"" + label_value(p.first) + '"', p.second);
+      }
+
+      double uploads = 0, downloads = 0;
+      for (auto& t : h.client.get_file_transfers())
+      {
+        (t.is_upload.value_or(false) ? uploads : downloads)++;
+      }
+      next[FILE_TRANSFERS].emplace_back("direction=\"download\"", downloads);
+      next[FILE_TRANSFERS].emplace_back("direction=\"upload\"", uploads);
+
+      for (auto& p : h.client.get_disk_usage().projects)
+      {
+        next[DISK_USAGE].emplace_back("project=\"" + label_value(p.master_url.value_or("").raw()) + '"', p.disk_usage.value_or(0));
+      }
+    }
+    catch (const std::exception& e)
+    {
+      next.assign(FAMILY_COUNT, Samples());
+      probe.reachable = false;
+    }
+  }
+  next[UP].emplace_back("", probe.reachable ? 1 : 0);
+
+  for (std::size_t f = 0; f < FAMILY_COUNT; f++)
+  {
+    this->update(h, f, next[f]);
+  }
+}
+
+void
+MetricsExporter::poll_all(std::size_t concurrency)
+{
+  WorkerPool pool(std::min(concurrency, this->hosts.size()));
+  this->poll_all(pool);
+}
+
+void
+MetricsExporter::poll_all(WorkerPool& pool)
+{
+  std::vector<std::future<void>> polls;
+  for (std::size_t i = 0; i < this->hosts.size(); i++)
+  {
+    auto task = std::make_shared<std::packaged_task<void()>>([this, i]() { this->poll_host(i); });
+    polls.push_back(task->get_future());
+    pool.submit([task]() { (*task)(); });
+  }
+  for (auto& poll : polls)
+  {
+    poll.wait();
+  }
+}
+
+std::string
+MetricsExporter::render() const
+{
+  std::vector<std::shared_ptr<const std::string>> fragments;
+  fragments.reserve(this->hosts.size() * FAMILY_COUNT);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (std::size_t f = 0; f < FAMILY_COUNT; f++)
+    {
+      for (auto& h : this->hosts)
+      {
+        fragments.push_back(h->fragments[f]);
+      }
+    }
+  }
+
+  std::size_t size = 0;
+  for (auto& fragment : fragments)
+  {
+    size += fragment ? fragment->size() : 0;
+  }
+
+  std::string page;
+  page.reserve(size + FAMILY_COUNT * 128);
+  auto fragment = fragments.begin();
+  for (std::size_t f = 0; f < FAMILY_COUNT; f++)
+  {
+    page += "# HELP ";
+    page += FAMILY_NAMES[f];
+    page += ' ';
+    page += FAMILY_HELP[f];
+    page += "\n# TYPE ";
+    page += FAMILY_NAMES[f];
+    page += " gauge\n";
+    for (std::size_t i = 0; i < this->hosts.size(); i++, fragment++)
+    {
+      if (*fragment)
+      {
+        page += **fragment;
+      }
+    }
+  }
+  return page;
+}
+
+void
+MetricsExporter::serve(int port, double interval)
+{
+  boost::asio::io_service ios;
+  boost::asio::ip::tcp::acceptor acceptor(ios, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), port));
+
+  std::thread([this, interval]() {
+    WorkerPool pool(std::min<std::size_t>(16, this->hosts.size()));
+    while (true)
+    {
+      auto started = std::chrono::steady_clock::now();
+      this->poll_all(pool);
+      std::this_thread::sleep_until(started + std::chrono::duration<double>(interval));
+    }
+  }).detach();
+
+  accept_scrape(ios, acceptor, *this);
+  ios.run();
+}
+}
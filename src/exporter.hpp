@@ -0,0 +1,57 @@
+#ifndef _EXPORTER_HPP_
+#define _EXPORTER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "client.hpp"
+#include "worker_pool.hpp"
+
+namespace Boinc
+{
+// Polls a set of daemons and keeps a Prometheus text exposition of them. Every host owns
+// one pre-rendered fragment per metric family; a poll re-renders only the fragments whose
+// samples changed, and a scrape just concatenates the cached fragments.
+class MetricsExporter
+{
+public:
+  explicit MetricsExporter(std::vector<Client>);
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  std::size_t size() const { return this->hosts.size(); }
+
+  // Must not run concurrently for the same host.
+  void poll_host(std::size_t);
+  // Polls every host and returns when all polls are done, on a temporary pool of at most
+  // the given number of threads or on the caller's pool.
+  void poll_all(std::size_t = 16);
+  void poll_all(WorkerPool&);
+  std::string render() const;
+
+  // Polls every interval seconds in the background and answers HTTP scrapes on 127.0.0.1:port,
+  // dropping connections that take longer than 10 seconds. Does not return.
+  void serve(int, double);
+
+private:
+  typedef std::vector<std::pair<std::string, double>> Samples;
+
+  struct HostMetrics
+  {
+    Client client;
+    std::string label;
+    std::vector<Samples> samples;
+    std::vector<std::shared_ptr<const std::string>> fragments;
+  };
+
+  void update(HostMetrics&, std::size_t, Samples&);
+
+  std::vector<std::unique_ptr<HostMetrics>> hosts;
+  mutable std::mutex mutex;
+};
+}
+#endif
@@ -0,0 +1,185 @@
+#ifndef _FIELDS_HPP_
+#define _FIELDS_HPP_
+
+#include <type_traits>
+
+#include "models.hpp"
+
+namespace Boinc
+{
+enum class FieldKind
+{
+  TEXT,
+  INTEGER,
+  REAL,
+  TIMESTAMP,
+  BOOLEAN,
+  TEXT_LIST
+};
+
+// Calls v(name, kind, field) for every field of the model, in declaration order.
+// Works on both const and mutable models so that the same field list drives encoders and decoders.
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, VersionInfo>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("major", FieldKind::INTEGER, m.major);
+  v("minor", FieldKind::INTEGER, m.minor);
+  v("release", FieldKind::INTEGER, m.release);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, HostInfo>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("tz_shift", FieldKind::INTEGER, m.tz_shift);
+  v("domain_name", FieldKind::TEXT, m.domain_name);
+  v("serialnum", FieldKind::TEXT, m.serialnum);
+  v("ip_addr", FieldKind::TEXT, m.ip_addr);
+  v("host_cpid", FieldKind::TEXT, m.host_cpid);
+
+  v("p_ncpus", FieldKind::INTEGER, m.p_ncpus);
+  v("p_vendor", FieldKind::TEXT, m.p_vendor);
+  v("p_model", FieldKind::TEXT, m.p_model);
+  v("p_features", FieldKind::TEXT, m.p_features);
+  v("p_fpops", FieldKind::REAL, m.p_fpops);
+  v("p_iops", FieldKind::REAL, m.p_iops);
+  v("p_membw", FieldKind::REAL, m.p_membw);
+  v("p_calculated", FieldKind::TIMESTAMP, m.p_calculated);
+  v("p_vm_extensions_disabled", FieldKind::BOOLEAN, m.p_vm_extensions_disabled);
+
+  v("m_nbytes", FieldKind::REAL, m.m_nbytes);
+  v("m_cache", FieldKind::REAL, m.m_cache);
+  v("m_swap", FieldKind::REAL, m.m_swap);
+
+  v("d_total", FieldKind::REAL, m.d_total);
+  v("d_free", FieldKind::REAL, m.d_free);
+
+  v("os_name", FieldKind::TEXT, m.os_name);
+  v("os_version", FieldKind::TEXT, m.os_version);
+  v("product_name", FieldKind::TEXT, m.product_name);
+
+  v("mac_address", FieldKind::TEXT, m.mac_address);
+
+  v("virtualbox_version", FieldKind::TEXT, m.virtualbox_version);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, ProjectInfo>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("name", FieldKind::TEXT, m.name);
+  v("summary", FieldKind::TEXT, m.summary);
+  v("url", FieldKind::TEXT, m.url);
+  v("general_area", FieldKind::TEXT, m.general_area);
+  v("specific_area", FieldKind::TEXT, m.specific_area);
+  v("description", FieldKind::TEXT, m.description);
+  v("home", FieldKind::TEXT, m.home);
+  v("platforms", FieldKind::TEXT_LIST, m.platforms);
+  v("image", FieldKind::TEXT, m.image);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, AccountManagerInfo>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("url", FieldKind::TEXT, m.url);
+  v("name", FieldKind::TEXT, m.name);
+  v("have_credentials", FieldKind::BOOLEAN, m.have_credentials);
+  v("cookie_required", FieldKind::BOOLEAN, m.cookie_required);
+  v("cookie_failure_url", FieldKind::TEXT, m.cookie_failure_url);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, Message>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("name", FieldKind::TEXT, m.name);
+  v("priority", FieldKind::INTEGER, m.priority);
+  v("msg_number", FieldKind::INTEGER, m.msg_number);
+  v("body", FieldKind::TEXT, m.body);
+  v("dt", FieldKind::TIMESTAMP, m.dt);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, Result>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("name", FieldKind::TEXT, m.name);
+  v("wu_name", FieldKind::TEXT, m.wu_name);
+  v("platform", FieldKind::TEXT, m.platform);
+  v("version_num", FieldKind::INTEGER, m.version_num);
+  v("plan_class", FieldKind::TEXT, m.plan_class);
+  v("project_url", FieldKind::TEXT, m.project_url);
+  v("final_cpu_time", FieldKind::REAL, m.final_cpu_time);
+  v("final_elapsed_time", FieldKind::REAL, m.final_elapsed_time);
+  v("exit_status", FieldKind::INTEGER, m.exit_status);
+  v("state", FieldKind::INTEGER, m.state);
+  v("report_deadline", FieldKind::TIMESTAMP, m.report_deadline);
+  v("received_time", FieldKind::TIMESTAMP, m.received_time);
+  v("estimated_cpu_time_remaining", FieldKind::REAL, m.estimated_cpu_time_remaining);
+  v("completed_time", FieldKind::TIMESTAMP, m.completed_time);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, CcStatus>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("network_status", FieldKind::INTEGER, m.network_status);
+  v("ams_password_error", FieldKind::BOOLEAN, m.ams_password_error);
+  v("task_suspend_reason", FieldKind::INTEGER, m.task_suspend_reason);
+  v("task_mode", FieldKind::INTEGER, m.task_mode);
+  v("task_mode_perm", FieldKind::INTEGER, m.task_mode_perm);
+  v("task_mode_delay", FieldKind::REAL, m.task_mode_delay);
+  v("gpu_suspend_reason", FieldKind::INTEGER, m.gpu_suspend_reason);
+  v("gpu_mode", FieldKind::INTEGER, m.gpu_mode);
+  v("gpu_mode_perm", FieldKind::INTEGER, m.gpu_mode_perm);
+  v("gpu_mode_delay", FieldKind::REAL, m.gpu_mode_delay);
+  v("network_suspend_reason", FieldKind::INTEGER, m.network_suspend_reason);
+  v("network_mode", FieldKind::INTEGER, m.network_mode);
+  v("network_mode_perm", FieldKind::INTEGER, m.network_mode_perm);
+  v("network_mode_delay", FieldKind::REAL, m.network_mode_delay);
+  v("disallow_attach", FieldKind::BOOLEAN, m.disallow_attach);
+  v("simple_gui_only", FieldKind::BOOLEAN, m.simple_gui_only);
+  v("max_event_log_lines", FieldKind::INTEGER, m.max_event_log_lines);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, FileTransfer>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("project_url", FieldKind::TEXT, m.project_url);
+  v("project_name", FieldKind::TEXT, m.project_name);
+  v("name", FieldKind::TEXT, m.name);
+  v("nbytes", FieldKind::REAL, m.nbytes);
+  v("status", FieldKind::INTEGER, m.status);
+  v("is_upload", FieldKind::BOOLEAN, m.is_upload);
+  v("num_retries", FieldKind::INTEGER, m.num_retries);
+  v("first_request_time", FieldKind::TIMESTAMP, m.first_request_time);
+  v("next_request_time", FieldKind::TIMESTAMP, m.next_request_time);
+  v("time_so_far", FieldKind::REAL, m.time_so_far);
+  v("bytes_xferred", FieldKind::REAL, m.bytes_xferred);
+  v("xfer_speed", FieldKind::REAL, m.xfer_speed);
+}
+
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, ProjectDiskUsage>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("master_url", FieldKind::TEXT, m.master_url);
+  v("disk_usage", FieldKind::REAL, m.disk_usage);
+}
+
+// DiskUsage::projects is not a field; visit its entries as ProjectDiskUsage. The serializers
+// write them as a "projects" array in JSON and as one line per project in line protocol.
+template <typename M, typename V>
+typename std::enable_if<std::is_same<typename std::remove_const<M>::type, DiskUsage>::value>::type
+visit_fields(M& m, V&& v)
+{
+  v("d_total", FieldKind::REAL, m.d_total);
+  v("d_free", FieldKind::REAL, m.d_free);
+  v("d_boinc", FieldKind::REAL, m.d_boinc);
+  v("d_allowed", FieldKind::REAL, m.d_allowed);
+}
+}
+#endif
@@ -0,0 +1,618 @@
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glibmm.h>
+
+#include "encoding.hpp"
+#include "exception_list.hpp"
+#include "fields.hpp"
+#include "models.hpp"
+
+#include "history.hpp"
+
+// File layout (all integers little-endian):
+//
+//   header:  "BOINCHS3" | u32 model | u32 column count | u8 kind per column
+//   block:   u32 BLOCK_MAGIC | u32 rows | u32 dictionary base | u32 dictionary entries | u64 dictionary size
+//            | u64 payload size | i64 appended_at (us)
+//   payload: new dictionary entries as (varint length, bytes), then for every column
+//            (varint column size, presence bitmap of ceil(rows / 8) bytes, values of present rows)
+//
+// Values: TEXT is a varint dictionary id, INTEGER a zigzag varint, REAL 8 raw bytes,
+// BOOLEAN one byte, TIMESTAMP a zigzag varint of the microsecond delta to the previous
+// present value of the same column in the block, or to appended_at for the first one.
+//
+// The dictionary is shared by all TEXT columns and carries over from block to block: a
+// block stores only the strings its predecessors did not, with ids continuing from the
+// dictionary base, the number of entries before it. A block with base 0 starts a new
+// dictionary. Writers start one every DICTIONARY_BLOCKS blocks, once DICTIONARY_BYTES of
+// strings have accumulated, and on reopening a file, which bounds both writer memory and
+// the blocks a reader walks to decode one.
+// A block whose payload runs past the end of the file is an interrupted append and is
+// ignored by readers and dropped by writers.
+
+namespace Boinc
+{
+namespace
+{
+const char FILE_MAGIC[8] = {'B', 'O', 'I', 'N', 'C', 'H', 'S', '3'};
+const std::uint32_t BLOCK_MAGIC = 0x314b4c42;
+const std::size_t BLOCK_HEADER_SIZE = 40;
+const std::uint32_t DICTIONARY_BLOCKS = 256;
+const std::size_t DICTIONARY_BYTES = 1 << 20;
+
+template <typename T>
+std::uint32_t history_model();
+
+template <>
+std::uint32_t
+history_model<Result>()
+{
+  return 1;
+}
+
+template <>
+std::uint32_t
+history_model<Message>()
+{
+  return 2;
+}
+
+template <>
+std::uint32_t
+history_model<HostInfo>()
+{
+  return 3;
+}
+
+template <typename T>
+std::string
+column_kinds()
+{
+  std::string kinds;
+  T entry;
+  visit_fields(entry, [&kinds](const char*, FieldKind kind, const auto&) { kinds += static_cast<char>(kind); });
+  return kinds;
+}
+
+std::int64_t
+to_microseconds(double v)
+{
+  if (!std::isfinite(v) || std::fabs(v) > 9.0e12)
+  {
+    throw HistoryError(Glib::ustring::compose("timestamp out of range: %1", v).raw());
+  }
+  return std::llround(v * 1e6);
+}
+
+struct Cursor
+{
+  const unsigned char* pos;
+  const unsigned char* end;
+
+  std::uint64_t varint()
+  {
+    std::uint64_t v;
+    if (!get_varint(pos, end, v))
+    {
+      throw HistoryError("truncated varint");
+    }
+    return v;
+  }
+
+  const unsigned char* take(std::size_t n)
+  {
+    if (static_cast<std::size_t>(end - pos) < n)
+    {
+      throw HistoryError("truncated column");
+    }
+    auto p = pos;
+    pos += n;
+    return p;
+  }
+};
+
+struct ColumnEncoder
+{
+  std::vector<std::string>& columns;
+  std::vector<std::int64_t>& timestamps;
+  std::unordered_map<std::string, std::uint32_t>& dictionary;
+  std::string& entries;
+  std::size_t row;
+  std::size_t index;
+
+  template <typename F>
+  void operator()(const char*, FieldKind kind, const std::experimental::optional<F>& field)
+  {
+    auto i = this->index++;
+    if (!field)
+    {
+      return;
+    }
+    this->columns[i][this->row / 8] |= static_cast<char>(1 << (this->row % 8));
+    this->encode(i, kind, *field);
+  }
+
+  void encode(std::size_t i, FieldKind, int v) { put_varint(this->columns[i], zigzag(v)); }
+
+  void encode(std::size_t i, FieldKind, bool v) { this->columns[i] += static_cast<char>(v ? 1 : 0); }
+
+  void encode(std::size_t i, FieldKind kind, double v)
+  {
+    if (kind == FieldKind::TIMESTAMP)
+    {
+      auto us = to_microseconds(v);
+      put_varint(this->columns[i], zigzag(us - this->timestamps[i]));
+      this->timestamps[i] = us;
+      return;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    put_uint(this->columns[i], bits, 8);
+  }
+
+  void encode(std::size_t i, FieldKind, const Glib::ustring& v)
+  {
+    auto it = this->dictionary.find(v.raw());
+    if (it == this->dictionary.end())
+    {
+      it = this->dictionary.emplace(v.raw(), static_cast<std::uint32_t>(this->dictionary.size())).first;
+      put_varint(this->entries, v.raw().size());
+      this->entries += v.raw();
+    }
+    put_varint(this->columns[i], it->second);
+  }
+};
+
+struct ColumnDecoder
+{
+  std::vector<Cursor>& cursors;
+  std::vector<const unsigned char*>& bitmaps;
+  std::vector<std::int64_t>& timestamps;
+  const unsigned char* data;
+  const std::vector<std::pair<std::size_t, std::size_t>>& dictionary;
+  std::size_t dictionary_size;
+  std::size_t row;
+  std::size_t index;
+
+  template <typename F>
+  void operator()(const char*, FieldKind kind, std::experimental::optional<F>& field)
+  {
+    auto i = this->index++;
+    if (!(this->bitmaps[i][this->row / 8] & (1 << (this->row % 8))))
+    {
+      return;
+    }
+    F v;
+    this->decode(i, kind, v);
+    field = v;
+  }
+
+  void decode(std::size_t i, FieldKind, int& v) { v = static_cast<int>(unzigzag(this->cursors[i].varint())); }
+
+  void decode(std::size_t i, FieldKind, bool& v) { v = *this->cursors[i].take(1) != 0; }
+
+  void decode(std::size_t i, FieldKind kind, double& v)
+  {
+    if (kind == FieldKind::TIMESTAMP)
+    {
+      this->timestamps[i] += unzigzag(this->cursors[i].varint());
+      v = this->timestamps[i] / 1e6;
+      return;
+    }
+    auto bits = get_uint(this->cursors[i].take(8), 8);
+    std::memcpy(&v, &bits, sizeof(v));
+  }
+
+  void decode(std::size_t i, FieldKind, Glib::ustring& v)
+  {
+    auto id = this->cursors[i].varint();
+    if (id >= this->dictionary_size)
+    {
+      throw HistoryError("dictionary id out of range");
+    }
+    auto& entry = this->dictionary[id];
+    v = std::string(reinterpret_cast<const char*>(this->data + entry.first), entry.second);
+  }
+};
+
+void
+write_all(int fd, const std::string& buf)
+{
+  std::size_t done = 0;
+  while (done < buf.size())
+  {
+    auto n = ::write(fd, buf.data() + done, buf.size() - done);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw HistoryError(std::strerror(errno));
+    }
+    done += n;
+  }
+}
+}
+
+template <typename T>
+HistoryReader<T>::HistoryReader(const std::string& path)
+: data(nullptr)
+, length(0)
+, scan_offset(0)
+, scan_done(false)
+, dictionary_chain(0)
+, dictionary_blocks(0)
+{
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(errno)).raw());
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0)
+  {
+    auto err = errno;
+    ::close(fd);
+    throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(err)).raw());
+  }
+  this->length = st.st_size;
+  if (this->length > 0)
+  {
+    auto p = ::mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      auto err = errno;
+      ::close(fd);
+      throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(err)).raw());
+    }
+    this->data = static_cast<const unsigned char*>(p);
+  }
+  ::close(fd);
+
+  auto kinds = column_kinds<T>();
+  auto header_size = sizeof(FILE_MAGIC) + 8 + kinds.size();
+  if (this->length < header_size || std::memcmp(this->data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || get_uint(this->data + 8, 4) != history_model<T>() ||
+      get_uint(this->data + 12, 4) != kinds.size() || std::memcmp(this->data + 16, kinds.data(), kinds.size()) != 0)
+  {
+    if (this->data)
+    {
+      ::munmap(const_cast<unsigned char*>(this->data), this->length);
+    }
+    throw HistoryError(Glib::ustring::compose("%1: not a history file for this model", path).raw());
+  }
+  this->scan_offset = header_size;
+}
+
+template <typename T>
+HistoryReader<T>::~HistoryReader()
+{
+  if (this->data)
+  {
+    ::munmap(const_cast<unsigned char*>(this->data), this->length);
+  }
+}
+
+template <typename T>
+bool
+HistoryReader<T>::index_next()
+{
+  if (this->scan_done)
+  {
+    return false;
+  }
+  auto offset = this->scan_offset;
+  if (this->length - offset < BLOCK_HEADER_SIZE || get_uint(this->data + offset, 4) != BLOCK_MAGIC)
+  {
+    this->scan_done = true;
+    return false;
+  }
+  auto dictionary_size = get_uint(this->data + offset + 16, 8);
+  auto payload_size = get_uint(this->data + offset + 24, 8);
+  if (this->length - offset - BLOCK_HEADER_SIZE < payload_size || payload_size < dictionary_size)
+  {
+    this->scan_done = true;
+    return false;
+  }
+
+  Block b;
+  b.rows = get_uint(this->data + offset + 4, 4);
+  b.dictionary_base = get_uint(this->data + offset + 8, 4);
+  b.dictionary_entries = get_uint(this->data + offset + 12, 4);
+  b.appended_at = static_cast<std::int64_t>(get_uint(this->data + offset + 32, 8));
+  b.dictionary_offset = offset + BLOCK_HEADER_SIZE;
+  b.columns_offset = b.dictionary_offset + dictionary_size;
+  b.end = offset + BLOCK_HEADER_SIZE + payload_size;
+  b.dictionary_chain = this->blocks.size();
+  if (b.dictionary_base != 0)
+  {
+    if (this->blocks.empty() || this->blocks.back().dictionary_base + this->blocks.back().dictionary_entries != b.dictionary_base)
+    {
+      throw HistoryError("history block continues a missing dictionary");
+    }
+    b.dictionary_chain = this->blocks.back().dictionary_chain;
+  }
+
+  this->blocks.push_back(b);
+  this->scan_offset = b.end;
+  return true;
+}
+
+template <typename T>
+void
+HistoryReader<T>::index_to(std::size_t i)
+{
+  while (this->blocks.size() <= i)
+  {
+    if (!this->index_next())
+    {
+      throw std::out_of_range("history block index out of range");
+    }
+  }
+}
+
+template <typename T>
+std::size_t
+HistoryReader<T>::size()
+{
+  while (this->index_next())
+  {
+  }
+  return this->blocks.size();
+}
+
+template <typename T>
+std::int64_t
+HistoryReader<T>::block_time(std::size_t i)
+{
+  this->index_to(i);
+  return this->blocks[i].appended_at;
+}
+
+// Extends the cached dictionary through block i, walking the dictionaries of the blocks
+// before it back to where its dictionary started.
+template <typename T>
+void
+HistoryReader<T>::load_dictionary(std::size_t i)
+{
+  auto chain = this->blocks[i].dictionary_chain;
+  if (this->dictionary_chain != chain || this->dictionary_blocks <= chain)
+  {
+    this->dictionary.clear();
+    this->dictionary_chain = chain;
+    this->dictionary_blocks = chain;
+  }
+  for (; this->dictionary_blocks <= i; this->dictionary_blocks++)
+  {
+    auto& b = this->blocks[this->dictionary_blocks];
+    Cursor d{this->data + b.dictionary_offset, this->data + b.columns_offset};
+    for (std::uint32_t j = 0; j < b.dictionary_entries; j++)
+    {
+      auto n = d.varint();
+      this->dictionary.emplace_back(d.take(n) - this->data, n);
+    }
+  }
+}
+
+template <typename T>
+void
+HistoryReader<T>::decode(std::size_t i, std::function<void(T&)> f)
+{
+  this->load_dictionary(i);
+  auto& b = this->blocks[i];
+  auto column_count = column_kinds<T>().size();
+  std::size_t bitmap_size = (b.rows + 7) / 8;
+
+  std::vector<Cursor> cursors;
+  std::vector<const unsigned char*> bitmaps;
+  std::vector<std::int64_t> timestamps(column_count, b.appended_at);
+
+  Cursor c{this->data + b.columns_offset, this->data + b.end};
+  for (std::size_t i = 0; i < column_count; i++)
+  {
+    auto n = c.varint();
+    Cursor column{c.take(n), c.pos};
+    bitmaps.push_back(column.take(bitmap_size));
+    cursors.push_back(column);
+  }
+
+  ColumnDecoder decoder{cursors, bitmaps, timestamps, this->data, this->dictionary, b.dictionary_base + b.dictionary_entries, 0, 0};
+  for (std::uint32_t row = 0; row < b.rows; row++)
+  {
+    T entry;
+    decoder.row = row;
+    decoder.index = 0;
+    visit_fields(entry, decoder);
+    f(entry);
+  }
+}
+
+template <typename T>
+std::vector<T>
+HistoryReader<T>::read(std::size_t i)
+{
+  this->index_to(i);
+  std::vector<T> v;
+  v.reserve(this->blocks[i].rows);
+  this->decode(i, [&v](T& entry) { v.push_back(std::move(entry)); });
+  return v;
+}
+
+template <typename T>
+void
+HistoryReader<T>::for_each(std::function<void(std::int64_t, const T&)> f, std::int64_t from, std::int64_t to)
+{
+  for (std::size_t i = 0; i < this->blocks.size() || this->index_next(); i++)
+  {
+    auto appended_at = this->blocks[i].appended_at;
+    if (appended_at < from || appended_at > to)
+    {
+      continue;
+    }
+    this->decode(i, [&f, appended_at](T& entry) { f(appended_at, entry); });
+  }
+}
+
+template <typename T>
+HistoryWriter<T>::HistoryWriter(const std::string& path)
+: fd(-1)
+, end(0)
+, dictionary_blocks(0)
+, dictionary_bytes(0)
+{
+  this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (this->fd < 0)
+  {
+    throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(errno)).raw());
+  }
+
+  try
+  {
+    struct stat st;
+    if (::fstat(this->fd, &st) != 0)
+    {
+      throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(errno)).raw());
+    }
+
+    if (st.st_size == 0)
+    {
+      auto kinds = column_kinds<T>();
+      std::string header(FILE_MAGIC, sizeof(FILE_MAGIC));
+      put_uint(header, history_model<T>(), 4);
+      put_uint(header, kinds.size(), 4);
+      header += kinds;
+      write_all(this->fd, header);
+      this->end = header.size();
+    }
+    else
+    {
+      HistoryReader<T> existing(path);
+      existing.size();
+      this->end = existing.scan_offset;
+      if (this->end != static_cast<std::uint64_t>(st.st_size) && ::ftruncate(this->fd, this->end) != 0)
+      {
+        throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(errno)).raw());
+      }
+    }
+
+    if (::lseek(this->fd, this->end, SEEK_SET) < 0)
+    {
+      throw HistoryError(Glib::ustring::compose("%1: %2", path, std::strerror(errno)).raw());
+    }
+  }
+  catch (...)
+  {
+    ::close(this->fd);
+    throw;
+  }
+
+  this->columns.resize(column_kinds<T>().size());
+  this->timestamps.resize(this->columns.size());
+}
+
+template <typename T>
+HistoryWriter<T>::~HistoryWriter()
+{
+  ::close(this->fd);
+}
+
+template <typename T>
+void
+HistoryWriter<T>::append(const std::vector<T>& rows, std::int64_t appended_at)
+{
+  if (appended_at == 0)
+  {
+    appended_at = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  std::size_t bitmap_size = (rows.size() + 7) / 8;
+  for (auto& column : this->columns)
+  {
+    column.assign(bitmap_size, '\0');
+  }
+  std::fill(this->timestamps.begin(), this->timestamps.end(), appended_at);
+  this->entries.clear();
+  if (this->dictionary_blocks >= DICTIONARY_BLOCKS || this->dictionary_bytes >= DICTIONARY_BYTES)
+  {
+    this->dictionary.clear();
+    this->dictionary_blocks = 0;
+    this->dictionary_bytes = 0;
+  }
+  auto dictionary_base = this->dictionary.size();
+
+  ColumnEncoder encoder{this->columns, this->timestamps, this->dictionary, this->entries, 0, 0};
+  try
+  {
+    for (std::size_t row = 0; row < rows.size(); row++)
+    {
+      encoder.row = row;
+      encoder.index = 0;
+      visit_fields(rows[row], encoder);
+    }
+
+    std::size_t payload_size = this->entries.size();
+    for (auto& column : this->columns)
+    {
+      std::string prefix;
+      put_varint(prefix, column.size());
+      payload_size += prefix.size() + column.size();
+    }
+
+    this->block.clear();
+    put_uint(this->block, BLOCK_MAGIC, 4);
+    put_uint(this->block, rows.size(), 4);
+    put_uint(this->block, dictionary_base, 4);
+    put_uint(this->block, this->dictionary.size() - dictionary_base, 4);
+    put_uint(this->block, this->entries.size(), 8);
+    put_uint(this->block, payload_size, 8);
+    put_uint(this->block, static_cast<std::uint64_t>(appended_at), 8);
+    this->block += this->entries;
+    for (auto& column : this->columns)
+    {
+      put_varint(this->block, column.size());
+      this->block += column;
+    }
+
+    write_all(this->fd, this->block);
+    this->end += this->block.size();
+    this->dictionary_blocks++;
+    this->dictionary_bytes += this->entries.size();
+  }
+  catch (...)
+  {
+    // The strings this block added were never written; start over with the next block.
+    this->dictionary.clear();
+    this->dictionary_blocks = 0;
+    this->dictionary_bytes = 0;
+    if (::ftruncate(this->fd, this->end) == 0)
+    {
+      ::lseek(this->fd, this->end, SEEK_SET);
+    }
+    throw;
+  }
+}
+
+template <typename T>
+void
+HistoryWriter<T>::append(const T& entry, std::int64_t appended_at)
+{
+  this->append(std::vector<T>{entry}, appended_at);
+}
+
+template class HistoryWriter<Result>;
+template class HistoryWriter<Message>;
+template class HistoryWriter<HostInfo>;
+template class HistoryReader<Result>;
+template class HistoryReader<Message>;
+template class HistoryReader<HostInfo>;
+}
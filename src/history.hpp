@@ -0,0 +1,100 @@
+#ifndef _HISTORY_HPP_
+#define _HISTORY_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "models.hpp"
+
+namespace Boinc
+{
+// Append-only columnar history of Result, Message or HostInfo snapshots.
+// Each append() writes one block. Strings are dictionary-encoded with a dictionary that
+// carries over between blocks and is restarted periodically, and TIMESTAMP fields are
+// delta-encoded from the block's append time. See history.cpp for the layout.
+// A file must have at most one writer at a time.
+template <typename T>
+class HistoryWriter
+{
+public:
+  explicit HistoryWriter(const std::string&);
+  HistoryWriter(const HistoryWriter&) = delete;
+  HistoryWriter& operator=(const HistoryWriter&) = delete;
+  ~HistoryWriter();
+
+  void append(const std::vector<T>&, std::int64_t = 0);
+  void append(const T&, std::int64_t = 0);
+
+private:
+  int fd;
+  std::uint64_t end;
+  std::unordered_map<std::string, std::uint32_t> dictionary;
+  std::uint32_t dictionary_blocks;
+  std::size_t dictionary_bytes;
+  std::vector<std::string> columns;
+  std::vector<std::int64_t> timestamps;
+  std::string entries;
+  std::string block;
+};
+
+// Memory-mapped reader over a snapshot of the file taken at open time.
+// Opening maps the file and checks its header only; block headers are
+// indexed lazily as blocks are requested.
+template <typename T>
+class HistoryReader
+{
+public:
+  explicit HistoryReader(const std::string&);
+  HistoryReader(const HistoryReader&) = delete;
+  HistoryReader& operator=(const HistoryReader&) = delete;
+  ~HistoryReader();
+
+  std::size_t size();
+  std::int64_t block_time(std::size_t);
+  std::vector<T> read(std::size_t);
+  void for_each(std::function<void(std::int64_t, const T&)>, std::int64_t = std::numeric_limits<std::int64_t>::min(), std::int64_t = std::numeric_limits<std::int64_t>::max());
+
+private:
+  template <typename>
+  friend class HistoryWriter;
+
+  struct Block
+  {
+    std::size_t dictionary_offset;
+    std::size_t columns_offset;
+    std::size_t end;
+    std::size_t dictionary_chain;
+    std::uint32_t rows;
+    std::uint32_t dictionary_base;
+    std::uint32_t dictionary_entries;
+    std::int64_t appended_at;
+  };
+
+  bool index_next();
+  void index_to(std::size_t);
+  void load_dictionary(std::size_t);
+  void decode(std::size_t, std::function<void(T&)>);
+
+  const unsigned char* data;
+  std::size_t length;
+  std::size_t scan_offset;
+  bool scan_done;
+  std::vector<Block> blocks;
+  std::size_t dictionary_chain;
+  std::size_t dictionary_blocks;
+  std::vector<std::pair<std::size_t, std::size_t>> dictionary;
+};
+
+extern template class HistoryWriter<Result>;
+extern template class HistoryWriter<Message>;
+extern template class HistoryWriter<HostInfo>;
+extern template class HistoryReader<Result>;
+extern template class HistoryReader<Message>;
+extern template class HistoryReader<HostInfo>;
+}
+#endif
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glibmm.h>
+
+#include "models.hpp"
+
+#include "message_index.hpp"
+
+namespace Boinc
+{
+namespace
+{
+const std::size_t CHUNK_SIZE = 1 << 20;
+const std::size_t TIME_BLOCK = 1024;
+
+enum Present : std::uint8_t
+{
+  NAME = 1,
+  PRIORITY = 2,
+  MSG_NUMBER = 4,
+  BODY = 8,
+  DT = 16
+};
+
+// Words are runs of ASCII letters and digits or non-ASCII bytes, so UTF-8 words stay whole.
+template <typename F>
+void
+for_each_word(const char* p, std::size_t n, F f)
+{
+  std::string word;
+  for (auto end = p + n; p != end; p++)
+  {
+    auto c = static_cast<unsigned char>(*p);
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c >= 0x80)
+    {
+      word += static_cast<char>(c);
+    }
+    else if (c >= 'A' && c <= 'Z')
+    {
+      word += static_cast<char>(c - 'A' + 'a');
+    }
+    else if (!word.empty())
+    {
+      f(word);
+      word.clear();
+    }
+  }
+  if (!word.empty())
+  {
+    f(word);
+  }
+}
+
+bool
+has_time_filter(const MessageQuery& query)
+{
+  return query.from != -std::numeric_limits<double>::infinity() || query.to != std::numeric_limits<double>::infinity();
+}
+
+std::vector<std::string>
+words_of(const char* p, std::size_t n)
+{
+  std::vector<std::string> words;
+  for_each_word(p, n, [&words](const std::string& w) { words.push_back(w); });
+  return words;
+}
+}
+
+MessageIndex::MessageIndex(std::size_t max_messages)
+: max_messages(max_messages)
+{
+}
+
+std::uint32_t
+MessageIndex::intern(std::vector<std::string>& names, std::unordered_map<std::string, std::uint32_t>& ids, const std::string& name)
+{
+  auto inserted = ids.emplace(name, names.size());
+  if (inserted.second)
+  {
+    names.push_back(name);
+  }
+  return inserted.first->second;
+}
+
+void
+MessageIndex::insert(std::uint32_t host, const Message& m)
+{
+  auto id = static_cast<std::uint32_t>(this->records.size());
+  Record r{host, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  if (m.name)
+  {
+    r.present |= NAME;
+    r.project = this->intern(this->projects, this->project_ids, m.name->raw());
+    if (r.project == this->project_records.size())
+    {
+      this->project_records.emplace_back();
+    }
+    this->project_records[r.project].push_back(id);
+  }
+  if (m.priority)
+  {
+    r.present |= PRIORITY;
+    r.priority = *m.priority;
+    this->priority_records[r.priority].push_back(id);
+  }
+  if (m.msg_number)
+  {
+    r.present |= MSG_NUMBER;
+    r.msg_number = *m.msg_number;
+  }
+  if (id % TIME_BLOCK == 0)
+  {
+    this->time_blocks.push_back({std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()});
+  }
+  if (m.dt)
+  {
+    r.present |= DT;
+    r.dt = *m.dt;
+    auto& range = this->time_blocks.back();
+    range.first = std::min(range.first, r.dt);
+    range.second = std::max(range.second, r.dt);
+  }
+  if (m.body)
+  {
+    auto& body = m.body->raw();
+    r.present |= BODY;
+    r.size = body.size();
+    if (body.size() > CHUNK_SIZE)
+    {
+      this->chunks.emplace_back(new char[body.size()]);
+      this->chunk_used = CHUNK_SIZE;
+    }
+    else
+    {
+      if (this->chunks.empty() || CHUNK_SIZE - this->chunk_used < body.size())
+      {
+        this->chunks.emplace_back(new char[CHUNK_SIZE]);
+        this->chunk_used = 0;
+      }
+      r.offset = this->chunk_used;
+      this->chunk_used += body.size();
+    }
+    r.chunk = this->chunks.size() - 1;
+    std::memcpy(this->chunks.back().get() + r.offset, body.data(), body.size());
+
+    for_each_word(body.data(), body.size(), [this, id](const std::string& w) {
+      auto& list = this->postings[w];
+      if (list.empty() || list.back() != id)
+      {
+        list.push_back(id);
+      }
+    });
+  }
+
+  this->records.push_back(r);
+}
+
+void
+MessageIndex::add_new(std::uint32_t host, const Message& m)
+{
+  if (host == this->host_last_msg_number.size())
+  {
+    this->host_last_msg_number.emplace_back();
+  }
+  auto& last = this->host_last_msg_number[host];
+  if (m.msg_number)
+  {
+    if (last && *m.msg_number <= *last)
+    {
+      return;
+    }
+    last = *m.msg_number;
+  }
+  this->insert(host, m);
+}
+
+// Re-inserts the newest max_messages records into fresh lists and arena.
+void
+MessageIndex::evict()
+{
+  auto old_records = std::move(this->records);
+  auto old_chunks = std::move(this->chunks);
+  this->records.clear();
+  this->chunks.clear();
+  this->chunk_used = 0;
+  this->project_records.assign(this->projects.size(), std::vector<std::uint32_t>());
+  this->priority_records.clear();
+  this->time_blocks.clear();
+  this->postings.clear();
+
+  this->records.reserve(this->max_messages);
+  for (auto i = old_records.size() - this->max_messages; i < old_records.size(); i++)
+  {
+    this->insert(old_records[i].host, this->message(old_records[i], old_chunks));
+  }
+}
+
+void
+MessageIndex::add(const std::string& host, const Message& m)
+{
+  this->add(host, std::vector<Message>{m});
+}
+
+void
+MessageIndex::add(const std::string& host, const std::vector<Message>& messages)
+{
+  std::lock_guard<std::shared_timed_mutex> lock(this->mutex);
+  auto id = this->intern(this->hosts, this->host_ids, host);
+  for (auto& m : messages)
+  {
+    this->add_new(id, m);
+  }
+  if (this->max_messages && this->records.size() > this->max_messages + this->max_messages / 4)
+  {
+    this->evict();
+  }
+}
+
+std::experimental::optional<int>
+MessageIndex::last_msg_number(const std::string& host) const
+{
+  std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+  auto it = this->host_ids.find(host);
+  if (it == this->host_ids.end() || it->second >= this->host_last_msg_number.size())
+  {
+    return std::experimental::nullopt;
+  }
+  return this->host_last_msg_number[it->second];
+}
+
+void
+MessageIndex::forget(const std::string& host)
+{
+  std::lock_guard<std::shared_timed_mutex> lock(this->mutex);
+  auto it = this->host_ids.find(host);
+  if (it != this->host_ids.end() && it->second < this->host_last_msg_number.size())
+  {
+    this->host_last_msg_number[it->second] = std::experimental::nullopt;
+  }
+}
+
+std::size_t
+MessageIndex::size() const
+{
+  std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+  return this->records.size();
+}
+
+bool
+MessageIndex::matches(const Record& r, const MessageQuery& query, std::uint32_t project, const std::vector<std::string>& words) const
+{
+  if (query.project && (!(r.present & NAME) || r.project != project))
+  {
+    return false;
+  }
+  if (query.priority && (!(r.present & PRIORITY) || r.priority != *query.priority))
+  {
+    return false;
+  }
+  if (has_time_filter(query) && (!(r.present & DT) || r.dt < query.from || r.dt > query.to))
+  {
+    return false;
+  }
+  if (words.size() < 2)
+  {
+    return true;
+  }
+
+  auto body = words_of(this->chunks[r.chunk].get() + r.offset, r.size);
+  return std::search(body.begin(), body.end(), words.begin(), words.end()) != body.end();
+}
+
+Message
+MessageIndex::message(const Record& r, const std::vector<std::unique_ptr<char[]>>& chunks) const
+{
+  Message m;
+  if (r.present & NAME)
+  {
+    m.name = Glib::ustring(this->projects[r.project]);
+  }
+  if (r.present & PRIORITY)
+  {
+    m.priority = r.priority;
+  }
+  if (r.present & MSG_NUMBER)
+  {
+    m.msg_number = r.msg_number;
+  }
+  if (r.present & BODY)
+  {
+    m.body = Glib::ustring(std::string(chunks[r.chunk].get() + r.offset, r.size));
+  }
+  if (r.present & DT)
+  {
+    m.dt = r.dt;
+  }
+  return m;
+}
+
+MessageHit
+MessageIndex::hit(const Record& r) const
+{
+  return MessageHit{this->hosts[r.host], this->message(r, this->chunks)};
+}
+
+std::vector<MessageHit>
+MessageIndex::search(const MessageQuery& query) const
+{
+  std::vector<MessageHit> hits;
+  auto words = words_of(query.text.data(), query.text.size());
+
+  std::shared_lock<std::shared_timed_mutex> lock(this->mutex);
+
+  std::vector<const std::vector<std::uint32_t>*> lists;
+  std::uint32_t project = 0;
+  if (query.project)
+  {
+    auto it = this->project_ids.find(*query.project);
+    if (it == this->project_ids.end())
+    {
+      return hits;
+    }
+    project = it->second;
+    lists.push_back(&this->project_records[project]);
+  }
+  if (query.priority)
+  {
+    auto it = this->priority_records.find(*query.priority);
+    if (it == this->priority_records.end())
+    {
+      return hits;
+    }
+    lists.push_back(&it->second);
+  }
+  for (auto& w : words)
+  {
+    auto it = this->postings.find(w);
+    if (it == this->postings.end())
+    {
+      return hits;
+    }
+    lists.push_back(&it->second);
+  }
+
+  auto consider = [&](std::uint32_t id) {
+    auto& r = this->records[id];
+    if (this->matches(r, query, project, words))
+    {
+      hits.push_back(this->hit(r));
+    }
+  };
+
+  // Blocks of consecutive records whose dt span misses the query range are skipped whole.
+  auto time_filter = has_time_filter(query);
+  auto block_in_range = [this, &query, time_filter](std::size_t block) {
+    auto& range = this->time_blocks[block];
+    return !time_filter || (range.second >= query.from && range.first <= query.to);
+  };
+
+  if (lists.empty())
+  {
+    for (auto block = this->time_blocks.size(); block-- > 0 && hits.size() < query.limit;)
+    {
+      if (!block_in_range(block))
+      {
+        continue;
+      }
+      auto first = block * TIME_BLOCK;
+      for (auto id = std::min(this->records.size(), first + TIME_BLOCK); id-- > first && hits.size() < query.limit;)
+      {
+        consider(id);
+      }
+    }
+    return hits;
+  }
+
+  // Walk the shortest list and probe the others.
+  std::sort(lists.begin(), lists.end(), [](const std::vector<std::uint32_t>* a, const std::vector<std::uint32_t>* b) { return a->size() < b->size(); });
+  auto& base = *lists.front();
+  for (auto it = base.rbegin(); it != base.rend() && hits.size() < query.limit; it++)
+  {
+    auto id = *it;
+    if (block_in_range(id / TIME_BLOCK) &&
+        std::all_of(lists.begin() + 1, lists.end(), [id](const std::vector<std::uint32_t>* l) { return std::binary_search(l->begin(), l->end(), id); }))
+    {
+      consider(id);
+    }
+  }
+  return hits;
+}
+}
@@ -0,0 +1,104 @@
+#ifndef _MESSAGE_INDEX_HPP_
+#define _MESSAGE_INDEX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <experimental/optional>
+
+#include "models.hpp"
+
+namespace Boinc
+{
+struct MessageQuery
+{
+  // Words that must appear consecutively in the body, compared case-insensitively. Empty matches every message.
+  std::string text;
+  std::experimental::optional<std::string> project;
+  std::experimental::optional<int> priority;
+  double from = -std::numeric_limits<double>::infinity();
+  double to = std::numeric_limits<double>::infinity();
+  std::size_t limit = 100;
+};
+
+struct MessageHit
+{
+  std::string host;
+  Message message;
+};
+
+// In-memory store of event log messages from many hosts. Bodies are packed into a
+// chunked arena. Every lowercased word, project and priority maps to the ascending list
+// of messages that have it, and every run of 1024 consecutive messages records its dt
+// span. A search intersects the lists of the query words and filters, skips runs
+// outside the time range, and checks the phrase against the stored body.
+//
+// The index holds at most about max_messages messages (0 for no limit): once a quarter
+// over, the oldest are dropped and the rest are re-indexed.
+class MessageIndex
+{
+public:
+  explicit MessageIndex(std::size_t = 1000000);
+  MessageIndex(const MessageIndex&) = delete;
+  MessageIndex& operator=(const MessageIndex&) = delete;
+
+  // Messages numbered at or below the highest msg_number already added for the host are
+  // skipped, so re-polling get_messages(0) adds only new ones. A daemon restart restarts
+  // its numbering; call forget() for the host first.
+  void add(const std::string&, const Message&);
+  void add(const std::string&, const std::vector<Message>&);
+
+  // Highest msg_number added for the host, to pass to get_messages() as the seqno.
+  std::experimental::optional<int> last_msg_number(const std::string&) const;
+  void forget(const std::string&);
+
+  std::size_t size() const;
+
+  // Newest additions first, at most query.limit hits.
+  std::vector<MessageHit> search(const MessageQuery&) const;
+
+private:
+  struct Record
+  {
+    std::uint32_t host;
+    std::uint32_t project;
+    std::uint32_t chunk;
+    std::uint32_t offset;
+    std::uint32_t size;
+    std::int32_t priority;
+    std::int32_t msg_number;
+    std::uint8_t present;
+    double dt;
+  };
+
+  void insert(std::uint32_t, const Message&);
+  void add_new(std::uint32_t, const Message&);
+  void evict();
+  Message message(const Record&, const std::vector<std::unique_ptr<char[]>>&) const;
+  std::uint32_t intern(std::vector<std::string>&, std::unordered_map<std::string, std::uint32_t>&, const std::string&);
+  bool matches(const Record&, const MessageQuery&, std::uint32_t, const std::vector<std::string>&) const;
+  MessageHit hit(const Record&) const;
+
+  std::size_t max_messages;
+  mutable std::shared_timed_mutex mutex;
+  std::vector<Record> records;
+  std::vector<std::unique_ptr<char[]>> chunks;
+  std::size_t chunk_used = 0;
+  std::vector<std::string> hosts;
+  std::unordered_map<std::string, std::uint32_t> host_ids;
+  std::vector<std::experimental::optional<int>> host_last_msg_number;
+  std::vector<std::string> projects;
+  std::unordered_map<std::string, std::uint32_t> project_ids;
+  std::vector<std::vector<std::uint32_t>> project_records;
+  std::unordered_map<int, std::vector<std::uint32_t>> priority_records;
+  std::vector<std::pair<double, double>> time_blocks;
+  std::unordered_map<std::string, std::vector<std::uint32_t>> postings;
+};
+}
+#endif
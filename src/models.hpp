@@ -1,6 +1,7 @@
 #ifndef _MODELS_HPP_
 #define _MODELS_HPP_
 
+#include <string>
 #include <vector>
 #include <experimental/optional>
 
@@ -117,6 +118,7 @@ struct AccountManagerInfo
 
 struct Message
 {
+  // The project the message is about, sent by the daemon as <project>.
   std::experimental::optional<Glib::ustring> name;
   std::experimental::optional<int> priority;
   std::experimental::optional<int> msg_number;
@@ -141,6 +143,68 @@ struct Result
   std::experimental::optional<double> estimated_cpu_time_remaining;
   std::experimental::optional<double> completed_time;
 };
+
+struct CcStatus
+{
+  std::experimental::optional<int> network_status;
+  std::experimental::optional<bool> ams_password_error;
+  std::experimental::optional<int> task_suspend_reason;
+  std::experimental::optional<int> task_mode;
+  std::experimental::optional<int> task_mode_perm;
+  std::experimental::optional<double> task_mode_delay;
+  std::experimental::optional<int> gpu_suspend_reason;
+  std::experimental::optional<int> gpu_mode;
+  std::experimental::optional<int> gpu_mode_perm;
+  std::experimental::optional<double> gpu_mode_delay;
+  std::experimental::optional<int> network_suspend_reason;
+  std::experimental::optional<int> network_mode;
+  std::experimental::optional<int> network_mode_perm;
+  std::experimental::optional<double> network_mode_delay;
+  std::experimental::optional<bool> disallow_attach;
+  std::experimental::optional<bool> simple_gui_only;
+  std::experimental::optional<int> max_event_log_lines;
+};
+
+struct FileTransfer
+{
+  std::experimental::optional<Glib::ustring> project_url;
+  std::experimental::optional<Glib::ustring> project_name;
+  std::experimental::optional<Glib::ustring> name;
+  std::experimental::optional<double> nbytes;
+  std::experimental::optional<int> status;
+  std::experimental::optional<bool> is_upload;
+  std::experimental::optional<int> num_retries;
+  std::experimental::optional<double> first_request_time;
+  std::experimental::optional<double> next_request_time;
+  std::experimental::optional<double> time_so_far;
+  std::experimental::optional<double> bytes_xferred;
+  std::experimental::optional<double> xfer_speed;
+};
+
+struct ProjectDiskUsage
+{
+  std::experimental::optional<Glib::ustring> master_url;
+  std::experimental::optional<double> disk_usage;
+};
+
+struct DiskUsage
+{
+  std::experimental::optional<double> d_total;
+  std::experimental::optional<double> d_free;
+  std::experimental::optional<double> d_boinc;
+  std::experimental::optional<double> d_allowed;
+  std::vector<ProjectDiskUsage> projects;
+};
+
+struct ProbeResult
+{
+  bool reachable = false;
+  // task_suspend_reason is 0: computation is allowed, whether or not any task is running.
+  bool not_suspended = false;
+  double latency = 0;
+  CcStatus status;
+  std::string error;
+};
 }
 
 #endif
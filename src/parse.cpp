@@ -0,0 +1,794 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/algorithm/string/trim_all.hpp>
+#include <glibmm.h>
+#include <libxml++/libxml++.h>
+#include <libxml/parser.h>
+
+#include "exception_list.hpp"
+#include "models.hpp"
+#include "reply_budget.hpp"
+#include "util.hpp"
+#include "worker_pool.hpp"
+
+#include "parse.hpp"
+
+namespace Boinc
+{
+namespace
+{
+std::atomic<std::size_t> parallel_decode_threshold(256 * 1024);
+
+std::size_t
+skip_past(const std::string& s, std::size_t pos, const char* terminator)
+{
+  auto end = s.find(terminator, pos);
+  return end == std::string::npos ? std::string::npos : end + std::strlen(terminator);
+}
+
+template <typename T>
+std::vector<T>
+decode_entry_span(const std::string& reply, const std::vector<EntryRange>& entries, std::size_t first, std::size_t last, const Glib::ustring& entry, T (*parse)(xmlpp::Node*))
+{
+  auto begin = entries[first].begin;
+  auto end = entries[last - 1].end;
+
+  std::string chunk;
+  chunk.reserve(end - begin + 7);
+  chunk += "<c>";
+  chunk.append(reply, begin, end - begin);
+  chunk += "</c>";
+
+  auto doc = load_xml(chunk);
+  std::vector<T> v;
+  v.reserve(last - first);
+  for (auto n : doc->get_root_node()->get_children(entry))
+  {
+    v.push_back(parse(n));
+  }
+  return v;
+}
+
+template <typename T>
+void
+decode_parallel(const std::string& reply, const std::vector<EntryRange>& entries, const Glib::ustring& entry, T (*parse)(xmlpp::Node*), std::vector<T>& v)
+{
+  static std::once_flag libxml_init;
+  std::call_once(libxml_init, []() { xmlInitParser(); });
+
+  auto& pool = shared_worker_pool();
+  auto chunks = std::min(pool.size() + 1, entries.size());
+  auto chunk_bytes = (entries.back().end - entries.front().begin) / chunks;
+
+  std::vector<std::pair<std::size_t, std::size_t>> spans;
+  std::size_t first = 0;
+  for (std::size_t i = 0; i < entries.size() && spans.size() + 1 < chunks; i++)
+  {
+    if (entries[i].end - entries[first].begin >= chunk_bytes)
+    {
+      spans.emplace_back(first, i + 1);
+      first = i + 1;
+    }
+  }
+  if (first < entries.size())
+  {
+    spans.emplace_back(first, entries.size());
+  }
+
+  std::vector<std::future<std::vector<T>>> parts;
+  for (std::size_t i = 1; i < spans.size(); i++)
+  {
+    auto span = spans[i];
+    auto task = std::make_shared<std::packaged_task<std::vector<T>()>>(
+      [&reply, &entries, span, &entry, parse]() { return decode_entry_span(reply, entries, span.first, span.second, entry, parse); });
+    parts.push_back(task->get_future());
+    pool.submit([task]() { (*task)(); });
+  }
+
+  std::vector<T> head;
+  std::exception_ptr error;
+  try
+  {
+    head = decode_entry_span(reply, entries, spans[0].first, spans[0].second, entry, parse);
+  }
+  catch (...)
+  {
+    error = std::current_exception();
+  }
+  for (auto& part : parts)
+  {
+    part.wait();
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+
+  v.reserve(v.size() + entries.size());
+  std::move(head.begin(), head.end(), std::back_inserter(v));
+  for (auto& part : parts)
+  {
+    auto decoded = part.get();
+    std::move(decoded.begin(), decoded.end(), std::back_inserter(v));
+  }
+}
+}
+
+std::shared_ptr<xmlpp::Document>
+load_reply(const std::string& data)
+{
+  auto doc = load_xml(boost::replace_all_copy(data, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" ?>", ""));
+  if (doc->get_root_node()->get_name() != "boinc_gui_rpc_reply")
+  {
+    throw DataParseError("invalid response XML root node");
+  }
+  return doc;
+}
+
+void
+verify_rpc_reply(xmlpp::Node* root_node)
+{
+  XMLCallbackMap b;
+
+  bool success = false;
+  b["success"] = [&success](xmlpp::Node*) {
+    success = true;
+    return;
+  };
+  b["status"] = [](xmlpp::Node* v) { throw NetworkError(v->eval_to_string(".")); };
+  b["unauthorized"] = [](xmlpp::Node*) { throw AuthError(); };
+  b["error"] = [](xmlpp::Node* v) {
+    auto error_msg = v->eval_to_string(".");
+
+    if ((error_msg == "unauthorized") || (error_msg == "Missing authenticator"))
+    {
+      throw AuthError(error_msg);
+    }
+    if (error_msg == "Missing URL")
+    {
+      throw InvalidURLError(error_msg);
+    }
+    if (error_msg == "Already attached to project")
+    {
+      throw AlreadyAttachedError(error_msg);
+    }
+
+    throw DataParseError(error_msg);
+  };
+
+  map_xml_node(root_node, b, [](Glib::ustring k) { throw DataParseError(Glib::ustring::compose("Unknown node '%1' in reply", k).raw()); });
+  if (!success)
+  {
+    throw DataParseError("success not confirmed in reply");
+  }
+}
+
+ReplyEntryWalker::ReplyEntryWalker(const Glib::ustring& container, const Glib::ustring& entry)
+: container(container.raw())
+, entry(entry.raw())
+{
+}
+
+bool
+ReplyEntryWalker::scan(const std::string& s, bool last, std::vector<EntryRange>& entries)
+{
+  bool complete = true;
+  while ((this->pos = s.find('<', this->pos)) != std::string::npos)
+  {
+    // Long enough to tell "<![CDATA[" from other markup.
+    if (!last && s.size() - this->pos < 9)
+    {
+      complete = false;
+      break;
+    }
+
+    std::size_t next;
+    if (s.compare(this->pos, 4, "<!--") == 0)
+    {
+      next = skip_past(s, this->pos, "-->");
+    }
+    else if (s.compare(this->pos, 9, "<![CDATA[") == 0)
+    {
+      next = skip_past(s, this->pos, "]]>");
+    }
+    else if (s.compare(this->pos, 2, "<?") == 0)
+    {
+      next = skip_past(s, this->pos, "?>");
+    }
+    else if (s.compare(this->pos, 2, "<!") == 0)
+    {
+      auto end = s.find('>', this->pos);
+      if (end != std::string::npos && s.find('[', this->pos) < end)
+      {
+        throw DataParseError("unsupported markup in reply");
+      }
+      next = end == std::string::npos ? end : end + 1;
+    }
+    else if (s.compare(this->pos, 2, "</") == 0)
+    {
+      auto end = s.find('>', this->pos);
+      if (end == std::string::npos)
+      {
+        complete = false;
+        break;
+      }
+      if (this->depth == 0)
+      {
+        throw DataParseError("unbalanced reply XML");
+      }
+      this->depth--;
+      if (this->depth == 2 && this->in_entry)
+      {
+        entries.push_back({this->element_begin, end + 1});
+        this->in_entry = false;
+      }
+      else if (this->depth == 1 && this->in_error)
+      {
+        auto doc = load_xml(s.substr(this->element_begin, end + 1 - this->element_begin));
+        throw DaemonError(Glib::ustring::compose("BOINC daemon returned error: %1", doc->get_root_node()->eval_to_string(".")).raw());
+      }
+      else if (this->depth == 1)
+      {
+        this->in_container = false;
+      }
+      next = end + 1;
+    }
+    else
+    {
+      auto name_end = s.find_first_of(" \t\r\n/>", this->pos + 1);
+      auto end = name_end;
+      char quote = 0;
+      for (; end < s.size(); end++)
+      {
+        if (quote)
+        {
+          quote = s[end] == quote ? 0 : quote;
+        }
+        else if (s[end] == '"' || s[end] == '\'')
+        {
+          quote = s[end];
+        }
+        else if (s[end] == '>')
+        {
+          break;
+        }
+      }
+      if (name_end == std::string::npos || end >= s.size())
+      {
+        complete = false;
+        break;
+      }
+      bool empty = s[end - 1] == '/';
+      auto name_is = [&s, this, name_end](const std::string& name) { return s.compare(this->pos + 1, name_end - this->pos - 1, name) == 0; };
+
+      if (this->depth == 0 && !name_is("boinc_gui_rpc_reply"))
+      {
+        throw DataParseError("invalid response XML root node");
+      }
+      if (this->depth == 1)
+      {
+        if (name_is(this->container))
+        {
+          this->container_found = true;
+          this->in_container = !empty;
+        }
+        else if (name_is("unauthorized"))
+        {
+          throw InvalidPasswordError();
+        }
+        else if (name_is("error"))
+        {
+          if (empty)
+          {
+            throw DaemonError("BOINC daemon returned error: ");
+          }
+          this->in_error = true;
+          this->element_begin = this->pos;
+        }
+      }
+      else if (this->depth == 2 && this->in_container && name_is(this->entry))
+      {
+        if (empty)
+        {
+          entries.push_back({this->pos, end + 1});
+        }
+        this->in_entry = !empty;
+        this->element_begin = this->pos;
+      }
+
+      if (!empty)
+      {
+        this->depth++;
+      }
+      next = end + 1;
+    }
+
+    if (next == std::string::npos)
+    {
+      complete = false;
+      break;
+    }
+    this->pos = next;
+  }
+  if (this->pos == std::string::npos)
+  {
+    this->pos = s.size();
+  }
+  return complete;
+}
+
+std::size_t
+ReplyEntryWalker::resume_point() const
+{
+  return this->in_entry || this->in_error ? this->element_begin : this->pos;
+}
+
+void
+ReplyEntryWalker::discard(std::size_t n)
+{
+  this->pos -= n;
+  this->element_begin -= std::min(this->element_begin, n);
+}
+
+ReplyEntryStream::ReplyEntryStream(const Glib::ustring& container, const Glib::ustring& entry, std::function<void(xmlpp::Node*)> callback)
+: walker(container, entry)
+, container(container.raw())
+, entry(entry.raw())
+, callback(std::move(callback))
+{
+}
+
+std::size_t
+ReplyEntryStream::feed(const char* data, std::size_t size, const ReplyCharge& charge)
+{
+  reserve_reply_buffer(this->pending, size, charge);
+  this->pending.append(data, size);
+  this->decode(false);
+  return this->pending.capacity();
+}
+
+void
+ReplyEntryStream::finish()
+{
+  auto complete = this->decode(true);
+  if (!this->walker.found())
+  {
+    throw DataParseError(Glib::ustring::compose("%1 node not found", this->container).raw());
+  }
+  if (!complete || !this->walker.closed())
+  {
+    throw DataParseError("truncated reply");
+  }
+}
+
+bool
+ReplyEntryStream::decode(bool last)
+{
+  std::vector<EntryRange> entries;
+  auto complete = this->walker.scan(this->pending, last, entries);
+
+  if (!entries.empty())
+  {
+    auto begin = entries.front().begin;
+    auto end = entries.back().end;
+
+    std::string chunk;
+    chunk.reserve(end - begin + 7);
+    chunk += "<c>";
+    chunk.append(this->pending, begin, end - begin);
+    chunk += "</c>";
+
+    auto doc = load_xml(chunk);
+    for (auto n : doc->get_root_node()->get_children(this->entry))
+    {
+      this->callback(n);
+    }
+  }
+
+  auto keep = this->walker.resume_point();
+  this->pending.erase(0, keep);
+  this->walker.discard(keep);
+  return complete;
+}
+
+void
+set_parallel_decode_threshold(std::size_t n)
+{
+  parallel_decode_threshold = n;
+}
+
+std::size_t
+get_parallel_decode_threshold()
+{
+  return parallel_decode_threshold;
+}
+
+bool
+find_reply_entries(const std::string& reply, const Glib::ustring& container, const Glib::ustring& entry, std::vector<EntryRange>& entries)
+{
+  ReplyEntryWalker walker(container, entry);
+  try
+  {
+    return walker.scan(reply, true, entries) && walker.found() && walker.closed();
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+}
+
+template <typename T>
+void
+decode_reply_entries(const std::string& reply, const Glib::ustring& container, const Glib::ustring& entry, T (*parse)(xmlpp::Node*), std::vector<T>& v)
+{
+  if (reply.size() >= get_parallel_decode_threshold())
+  {
+    std::vector<EntryRange> entries;
+    if (find_reply_entries(reply, container, entry, entries) && entries.size() > 1)
+    {
+      decode_parallel(reply, entries, entry, parse, v);
+      return;
+    }
+  }
+
+  auto doc = load_reply(reply);
+  bool success = false;
+  XMLCallbackMap b;
+  b[container] = [&v, &success, &entry, parse](xmlpp::Node* n) {
+    success = true;
+    auto entries = n->get_children(entry);
+    v.reserve(v.size() + entries.size());
+    for (auto entry_node : entries)
+    {
+      v.push_back(parse(entry_node));
+    }
+  };
+  b["error"] = [](xmlpp::Node* n) { throw DaemonError(Glib::ustring::compose("BOINC daemon returned error: %1", n->eval_to_string(".")).raw()); };
+  b["unauthorized"] = [](xmlpp::Node*) { throw InvalidPasswordError(); };
+  map_xml_node(doc->get_root_node(), b);
+  if (!success)
+  {
+    throw DataParseError(Glib::ustring::compose("%1 node not found", container).raw());
+  }
+}
+
+template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, Message (*)(xmlpp::Node*), std::vector<Message>&);
+template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, Result (*)(xmlpp::Node*), std::vector<Result>&);
+template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, ProjectInfo (*)(xmlpp::Node*), std::vector<ProjectInfo>&);
+template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, FileTransfer (*)(xmlpp::Node*), std::vector<FileTransfer>&);
+
+Message
+parse_message(xmlpp::Node* entry_node)
+{
+  Message entry;
+
+  XMLCallbackMap b;
+  b["name"] = [&entry](xmlpp::Node* node) { entry.name = node->eval_to_string("."); };
+  // The daemon sends the message's project as <project>; Message::name holds it.
+  b["project"] = [&entry](xmlpp::Node* node) { entry.name = node->eval_to_string("."); };
+  b["pri"] = [&entry](xmlpp::Node* node) {
+    auto text = node->eval_to_string(".");
+    if (!text.empty())
+    {
+      entry.priority = std::stoi(text);
+    }
+  };
+  b["seqno"] = [&entry](xmlpp::Node* node) {
+    auto text = node->eval_to_string(".");
+    if (!text.empty())
+    {
+      entry.msg_number = std::stoi(text);
+    }
+  };
+  b["body"] = [&entry](xmlpp::Node* node) {
+    auto text = boost::algorithm::trim_all_copy_if(node->eval_to_string(".").raw(), [](char c) { return c == '\n' || c == ' '; });
+    if (!text.empty())
+    {
+      entry.body = text;
+    }
+  };
+  b["time"] = [&entry](xmlpp::Node* node) {
+    auto text = node->eval_to_string(".");
+    if (!text.empty())
+    {
+      entry.dt = node->eval_to_number(".");
+    }
+  };
+  map_xml_node(entry_node, b);
+
+  return entry;
+}
+
+Result
+parse_result(xmlpp::Node* entry_node)
+{
+  Result entry;
+
+  XMLCallbackMap b;
+  b["name"] = [&entry](xmlpp::Node* subnode) { entry.name = subnode->eval_to_string("."); };
+  b["wu_name"] = [&entry](xmlpp::Node* subnode) { entry.wu_name = subnode->eval_to_string("."); };
+  b["platform"] = [&entry](xmlpp::Node* subnode) { entry.platform = subnode->eval_to_string("."); };
+  b["version_num"] = [&entry](xmlpp::Node* subnode) { entry.version_num = subnode->eval_to_number("."); };
+  b["plan_class"] = [&entry](xmlpp::Node* subnode) { entry.plan_class = subnode->eval_to_string("."); };
+  b["project_url"] = [&entry](xmlpp::Node* subnode) { entry.project_url = subnode->eval_to_string("."); };
+  b["final_cpu_time"] = [&entry](xmlpp::Node* subnode) { entry.final_cpu_time = subnode->eval_to_number("."); };
+  b["final_elapsed_time"] = [&entry](xmlpp::Node* subnode) { entry.final_elapsed_time = subnode->eval_to_number("."); };
+  b["exit_status"] = [&entry](xmlpp::Node* subnode) { entry.exit_status = subnode->eval_to_number("."); };
+  b["state"] = [&entry](xmlpp::Node* subnode) { entry.state = subnode->eval_to_number("."); };
+  b["report_deadline"] = [&entry](xmlpp::Node* subnode) { entry.report_deadline = subnode->eval_to_number("."); };
+  b["received_time"] = [&entry](xmlpp::Node* subnode) { entry.received_time = subnode->eval_to_number("."); };
+  b["estimated_cpu_time_remaining"] = [&entry](xmlpp::Node* subnode) { entry.estimated_cpu_time_remaining = subnode->eval_to_number("."); };
+  b["completed_time"] = [&entry](xmlpp::Node* subnode) { entry.completed_time = subnode->eval_to_number("."); };
+  map_xml_node(entry_node, b);
+
+  return entry;
+}
+
+ProjectInfo
+parse_project(xmlpp::Node* entry_node)
+{
+  ProjectInfo entry;
+
+  XMLCallbackMap b;
+  b["name"] = [&entry](xmlpp::Node* node) { entry.name = node->eval_to_string("."); };
+  b["summary"] = [&entry](xmlpp::Node* node) { entry.summary = node->eval_to_string("."); };
+  b["url"] = [&entry](xmlpp::Node* node) { entry.url = node->eval_to_string("."); };
+  b["general_area"] = [&entry](xmlpp::Node* node) { entry.general_area = node->eval_to_string("."); };
+  b["specific_area"] = [&entry](xmlpp::Node* node) { entry.specific_area = node->eval_to_string("."); };
+  b["description"] = [&entry](xmlpp::Node* node) {
+    Glib::ustring body;
+    for (auto subnode : node->get_children())
+    {
+      body += subnode->eval_to_string(".");
+    }
+    entry.description = body;
+  };
+  b["home"] = [&entry](xmlpp::Node* node) { entry.home = node->eval_to_string("."); };
+  b["platforms"] = [&entry](xmlpp::Node* node) {
+    std::vector<Glib::ustring> arr;
+    for (auto subnode : node->get_children())
+    {
+      if (subnode->get_name() == "platform")
+      {
+        auto text = subnode->eval_to_string(".");
+        if (!text.empty())
+        {
+          arr.push_back(text);
+        }
+      }
+    }
+    entry.platforms = arr;
+  };
+  b["image"] = [&entry](xmlpp::Node* node) { entry.image = node->eval_to_string("."); };
+  map_xml_node(entry_node, b);
+
+  return entry;
+}
+
+AccountManagerInfo
+parse_account_manager_info_reply(xmlpp::Node* root_node)
+{
+  AccountManagerInfo v;
+  bool success = false;
+  XMLCallbackMap b;
+  b["acct_mgr_info"] = [&v, &success](xmlpp::Node* n) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["acct_mgr_url"] = [&v](xmlpp::Node* node) { v.url = node->eval_to_string("."); };
+    b2["acct_mgr_name"] = [&v](xmlpp::Node* node) { v.name = node->eval_to_string("."); };
+    b2["have_credentials"] = [&v](xmlpp::Node* node) { v.have_credentials = true; };
+    b2["cookie_required"] = [&v](xmlpp::Node* node) { v.cookie_required = true; };
+    b2["cookie_failure_url"] = [&v](xmlpp::Node* node) { v.cookie_failure_url = node->eval_to_string("."); };
+    map_xml_node(n, b2);
+  };
+  map_xml_node(root_node, b);
+  if (!success)
+  {
+    throw DataParseError("acct_mgr_info node not found");
+  }
+  return v;
+}
+
+int
+parse_account_manager_rpc_status_reply(xmlpp::Node* root_node)
+{
+  int v = 0;
+  bool success = false;
+  XMLCallbackMap b;
+  b["acct_mgr_rpc_reply"] = [&v, &success](xmlpp::Node* n) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["error_num"] = [&v](xmlpp::Node* node) { v = node->eval_to_number("."); };
+    map_xml_node(n, b2);
+  };
+  map_xml_node(root_node, b);
+  if (!success)
+  {
+    throw DataParseError("acct_mgr_rpc_reply node not found");
+  }
+  return v;
+}
+
+VersionInfo
+parse_version_info_reply(xmlpp::Node* root_node)
+{
+  VersionInfo v;
+  bool success = false;
+  XMLCallbackMap b;
+  b["server_version"] = [&v, &success](xmlpp::Node* node) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["major"] = [&v](xmlpp::Node* n) { v.major = n->eval_to_number("."); };
+    b2["minor"] = [&v](xmlpp::Node* n) { v.minor = n->eval_to_number("."); };
+    b2["release"] = [&v](xmlpp::Node* n) { v.release = n->eval_to_number("."); };
+    map_xml_node(node, b2);
+  };
+  map_xml_node(root_node, b);
+  if (!success)
+  {
+    throw DataParseError("server_version node not found");
+  }
+  return v;
+}
+
+HostInfo
+parse_host_info_reply(xmlpp::Node* root_node)
+{
+  HostInfo v;
+  bool success = false;
+
+  XMLCallbackMap b;
+  b["host_info"] = [&v, &success](xmlpp::Node* n) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["p_fpops"] = [&v](xmlpp::Node* node) { v.p_fpops = node->eval_to_number("."); };
+    b2["p_iops"] = [&v](xmlpp::Node* node) { v.p_iops = node->eval_to_number("."); };
+    b2["p_membw"] = [&v](xmlpp::Node* node) { v.p_membw = node->eval_to_number("."); };
+    b2["p_calculated"] = [&v](xmlpp::Node* node) { v.p_calculated = node->eval_to_number("."); };
+    b2["p_vm_extensions_disabled"] = [&v](xmlpp::Node* node) { v.p_vm_extensions_disabled = node->eval_to_boolean("."); };
+    b2["host_cpid"] = [&v](xmlpp::Node* node) { v.host_cpid = node->eval_to_string("."); };
+    b2["product_name"] = [&v](xmlpp::Node* node) { v.product_name = node->eval_to_string("."); };
+    b2["mac_address"] = [&v](xmlpp::Node* node) { v.mac_address = node->eval_to_string("."); };
+    b2["domain_name"] = [&v](xmlpp::Node* node) { v.domain_name = node->eval_to_string("."); };
+
+    b2["ip_addr"] = [&v](xmlpp::Node* node) { v.ip_addr = node->eval_to_string("."); };
+    b2["p_vendor"] = [&v](xmlpp::Node* node) { v.p_vendor = node->eval_to_string("."); };
+    b2["p_model"] = [&v](xmlpp::Node* node) { v.p_model = node->eval_to_string("."); };
+    b2["os_name"] = [&v](xmlpp::Node* node) { v.os_name = node->eval_to_string("."); };
+    b2["os_version"] = [&v](xmlpp::Node* node) { v.os_version = node->eval_to_string("."); };
+    b2["virtualbox_version"] = [&v](xmlpp::Node* node) { v.virtualbox_version = node->eval_to_string("."); };
+    b2["p_features"] = [&v](xmlpp::Node* node) { v.p_features = node->eval_to_string("."); };
+
+    b2["timezone"] = [&v](xmlpp::Node* node) { v.tz_shift = node->eval_to_number("."); };
+    b2["p_ncpus"] = [&v](xmlpp::Node* node) { v.p_ncpus = node->eval_to_number("."); };
+
+    b2["m_nbytes"] = [&v](xmlpp::Node* node) { v.m_nbytes = node->eval_to_number("."); };
+    b2["m_cache"] = [&v](xmlpp::Node* node) { v.m_cache = node->eval_to_number("."); };
+    b2["m_swap"] = [&v](xmlpp::Node* node) { v.m_swap = node->eval_to_number("."); };
+    b2["d_total"] = [&v](xmlpp::Node* node) { v.d_total = node->eval_to_number("."); };
+    b2["d_free"] = [&v](xmlpp::Node* node) { v.d_free = node->eval_to_number("."); };
+
+    map_xml_node(n, b2);
+  };
+  map_xml_node(root_node, b);
+
+  if (!success)
+  {
+    throw DataParseError("host_info node not found");
+  }
+  return v;
+}
+
+CcStatus
+parse_cc_status_reply(xmlpp::Node* root_node)
+{
+  CcStatus v;
+  bool success = false;
+
+  XMLCallbackMap b;
+  b["cc_status"] = [&v, &success](xmlpp::Node* n) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["network_status"] = [&v](xmlpp::Node* node) { v.network_status = node->eval_to_number("."); };
+    b2["ams_password_error"] = [&v](xmlpp::Node* node) { v.ams_password_error = node->eval_to_number(".") != 0; };
+    b2["task_suspend_reason"] = [&v](xmlpp::Node* node) { v.task_suspend_reason = node->eval_to_number("."); };
+    b2["task_mode"] = [&v](xmlpp::Node* node) { v.task_mode = node->eval_to_number("."); };
+    b2["task_mode_perm"] = [&v](xmlpp::Node* node) { v.task_mode_perm = node->eval_to_number("."); };
+    b2["task_mode_delay"] = [&v](xmlpp::Node* node) { v.task_mode_delay = node->eval_to_number("."); };
+    b2["gpu_suspend_reason"] = [&v](xmlpp::Node* node) { v.gpu_suspend_reason = node->eval_to_number("."); };
+    b2["gpu_mode"] = [&v](xmlpp::Node* node) { v.gpu_mode = node->eval_to_number("."); };
+    b2["gpu_mode_perm"] = [&v](xmlpp::Node* node) { v.gpu_mode_perm = node->eval_to_number("."); };
+    b2["gpu_mode_delay"] = [&v](xmlpp::Node* node) { v.gpu_mode_delay = node->eval_to_number("."); };
+    b2["network_suspend_reason"] = [&v](xmlpp::Node* node) { v.network_suspend_reason = node->eval_to_number("."); };
+    b2["network_mode"] = [&v](xmlpp::Node* node) { v.network_mode = node->eval_to_number("."); };
+    b2["network_mode_perm"] = [&v](xmlpp::Node* node) { v.network_mode_perm = node->eval_to_number("."); };
+    b2["network_mode_delay"] = [&v](xmlpp::Node* node) { v.network_mode_delay = node->eval_to_number("."); };
+    b2["disallow_attach"] = [&v](xmlpp::Node* node) { v.disallow_attach = node->eval_to_number(".") != 0; };
+    b2["simple_gui_only"] = [&v](xmlpp::Node* node) { v.simple_gui_only = node->eval_to_number(".") != 0; };
+    b2["max_event_log_lines"] = [&v](xmlpp::Node* node) { v.max_event_log_lines = node->eval_to_number("."); };
+    map_xml_node(n, b2);
+  };
+  map_xml_node(root_node, b);
+
+  if (!success)
+  {
+    throw DataParseError("cc_status node not found");
+  }
+  return v;
+}
+
+FileTransfer
+parse_file_transfer(xmlpp::Node* entry_node)
+{
+  FileTransfer entry;
+
+  XMLCallbackMap b;
+  b["project_url"] = [&entry](xmlpp::Node* node) { entry.project_url = node->eval_to_string("."); };
+  b["project_name"] = [&entry](xmlpp::Node* node) { entry.project_name = node->eval_to_string("."); };
+  b["name"] = [&entry](xmlpp::Node* node) { entry.name = node->eval_to_string("."); };
+  b["nbytes"] = [&entry](xmlpp::Node* node) { entry.nbytes = node->eval_to_number("."); };
+  b["status"] = [&entry](xmlpp::Node* node) { entry.status = node->eval_to_number("."); };
+  b["persistent_file_xfer"] = [&entry](xmlpp::Node* n) {
+    XMLCallbackMap b2;
+    b2["num_retries"] = [&entry](xmlpp::Node* node) { entry.num_retries = node->eval_to_number("."); };
+    b2["first_request_time"] = [&entry](xmlpp::Node* node) { entry.first_request_time = node->eval_to_number("."); };
+    b2["next_request_time"] = [&entry](xmlpp::Node* node) { entry.next_request_time = node->eval_to_number("."); };
+    b2["time_so_far"] = [&entry](xmlpp::Node* node) { entry.time_so_far = node->eval_to_number("."); };
+    b2["is_upload"] = [&entry](xmlpp::Node* node) { entry.is_upload = node->eval_to_number(".") != 0; };
+    map_xml_node(n, b2);
+  };
+  b["file_xfer"] = [&entry](xmlpp::Node* n) {
+    XMLCallbackMap b2;
+    b2["bytes_xferred"] = [&entry](xmlpp::Node* node) { entry.bytes_xferred = node->eval_to_number("."); };
+    b2["xfer_speed"] = [&entry](xmlpp::Node* node) { entry.xfer_speed = node->eval_to_number("."); };
+    map_xml_node(n, b2);
+  };
+  map_xml_node(entry_node, b);
+
+  return entry;
+}
+
+DiskUsage
+parse_disk_usage_reply(xmlpp::Node* root_node)
+{
+  DiskUsage v;
+  bool success = false;
+
+  XMLCallbackMap b;
+  b["disk_usage_summary"] = [&v, &success](xmlpp::Node* n) {
+    success = true;
+    XMLCallbackMap b2;
+    b2["project"] = [&v](xmlpp::Node* entry_node) {
+      ProjectDiskUsage entry;
+      XMLCallbackMap b3;
+      b3["master_url"] = [&entry](xmlpp::Node* node) { entry.master_url = node->eval_to_string("."); };
+      b3["disk_usage"] = [&entry](xmlpp::Node* node) { entry.disk_usage = node->eval_to_number("."); };
+      map_xml_node(entry_node, b3);
+      v.projects.push_back(std::move(entry));
+    };
+    b2["d_total"] = [&v](xmlpp::Node* node) { v.d_total = node->eval_to_number("."); };
+    b2["d_free"] = [&v](xmlpp::Node* node) { v.d_free = node->eval_to_number("."); };
+    b2["d_boinc"] = [&v](xmlpp::Node* node) { v.d_boinc = node->eval_to_number("."); };
+    b2["d_allowed"] = [&v](xmlpp::Node* node) { v.d_allowed = node->eval_to_number("."); };
+    map_xml_node(n, b2);
+  };
+  map_xml_node(root_node, b);
+
+  if (!success)
+  {
+    throw DataParseError("disk_usage_summary node not found");
+  }
+  return v;
+}
+}
@@ -0,0 +1,112 @@
+#ifndef _PARSE_HPP_
+#define _PARSE_HPP_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libxml++/libxml++.h>
+
+#include "models.hpp"
+#include "reply_budget.hpp"
+
+namespace Boinc
+{
+std::shared_ptr<xmlpp::Document> load_reply(const std::string&);
+void verify_rpc_reply(xmlpp::Node*);
+
+struct EntryRange
+{
+  std::size_t begin;
+  std::size_t end;
+};
+
+// Tag walk over a raw reply that finds every entry element directly under the container
+// element. The reply may be scanned in pieces: each call resumes where the last stopped.
+// Throws InvalidPasswordError or DaemonError for daemon error replies and DataParseError
+// for markup it cannot split safely (DTDs, a wrong root element, unbalanced tags).
+class ReplyEntryWalker
+{
+public:
+  ReplyEntryWalker(const Glib::ustring&, const Glib::ustring&);
+
+  // Appends the range of every entry that ends in the text. Unless last is set, a tag or
+  // comment cut off by the end of the text is left for the next call. Returns false if the
+  // text ends inside such a construct.
+  bool scan(const std::string&, bool, std::vector<EntryRange>&);
+
+  // Offset of the first byte later scans still need, and the call to make after the caller
+  // drops that many bytes from the front of the text.
+  std::size_t resume_point() const;
+  void discard(std::size_t);
+
+  bool found() const { return this->container_found; }
+  bool closed() const { return this->depth == 0; }
+
+private:
+  std::string container;
+  std::string entry;
+  std::size_t pos = 0;
+  std::size_t element_begin = 0;
+  int depth = 0;
+  bool container_found = false;
+  bool in_container = false;
+  bool in_entry = false;
+  bool in_error = false;
+};
+
+// Decodes the entries of a reply that arrives in pieces. Complete entries are handed to the
+// callback as soon as their closing tag is fed, and the bytes they occupied are dropped, so
+// only a partial entry is buffered.
+class ReplyEntryStream
+{
+public:
+  ReplyEntryStream(const Glib::ustring&, const Glib::ustring&, std::function<void(xmlpp::Node*)>);
+
+  // Returns the bytes allocated for the partial entry kept buffered, which may exceed its length.
+  // Growth of that buffer is charged first when a charge function is given.
+  std::size_t feed(const char*, std::size_t, const ReplyCharge& = nullptr);
+  void finish();
+
+private:
+  bool decode(bool);
+
+  ReplyEntryWalker walker;
+  std::string container;
+  std::string entry;
+  std::function<void(xmlpp::Node*)> callback;
+  std::string pending;
+};
+
+// Byte ranges of every entry element directly under a container element of a raw reply.
+// Returns false for replies it cannot split safely (daemon errors, DTDs, malformed markup).
+bool find_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, std::vector<EntryRange>&);
+
+void set_parallel_decode_threshold(std::size_t);
+std::size_t get_parallel_decode_threshold();
+
+// Decodes every container/entry element of a raw reply into the vector, in document order.
+// Replies of at least get_parallel_decode_threshold() bytes are split at entry boundaries
+// and the pieces decoded on shared_worker_pool(); smaller ones go through a single DOM.
+template <typename T>
+void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, T (*)(xmlpp::Node*), std::vector<T>&);
+
+extern template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, Message (*)(xmlpp::Node*), std::vector<Message>&);
+extern template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, Result (*)(xmlpp::Node*), std::vector<Result>&);
+extern template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, ProjectInfo (*)(xmlpp::Node*), std::vector<ProjectInfo>&);
+extern template void decode_reply_entries(const std::string&, const Glib::ustring&, const Glib::ustring&, FileTransfer (*)(xmlpp::Node*), std::vector<FileTransfer>&);
+
+Message parse_message(xmlpp::Node*);
+Result parse_result(xmlpp::Node*);
+ProjectInfo parse_project(xmlpp::Node*);
+FileTransfer parse_file_transfer(xmlpp::Node*);
+
+AccountManagerInfo parse_account_manager_info_reply(xmlpp::Node*);
+int parse_account_manager_rpc_status_reply(xmlpp::Node*);
+VersionInfo parse_version_info_reply(xmlpp::Node*);
+HostInfo parse_host_info_reply(xmlpp::Node*);
+CcStatus parse_cc_status_reply(xmlpp::Node*);
+DiskUsage parse_disk_usage_reply(xmlpp::Node*);
+}
+#endif
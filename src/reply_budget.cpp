@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include <glibmm.h>
+
+#include "exception_list.hpp"
+
+#include "reply_budget.hpp"
+
+namespace Boinc
+{
+namespace
+{
+std::mutex budget_mutex;
+std::condition_variable budget_released;
+ReplyBudget budget;
+std::size_t in_use = 0;
+
+std::shared_ptr<const RpcMemoryObserver> memory_observer;
+}
+
+void
+set_reply_budget(const ReplyBudget& b)
+{
+  if ((b.per_call && b.per_call < REPLY_READ_SIZE) || (b.total && b.total < REPLY_READ_SIZE))
+  {
+    throw std::invalid_argument("reply budget limits must be 0 or at least REPLY_READ_SIZE");
+  }
+  {
+    std::lock_guard<std::mutex> lock(budget_mutex);
+    budget = b;
+  }
+  budget_released.notify_all();
+}
+
+ReplyBudget
+get_reply_budget()
+{
+  std::lock_guard<std::mutex> lock(budget_mutex);
+  return budget;
+}
+
+std::size_t
+reply_memory_in_use()
+{
+  std::lock_guard<std::mutex> lock(budget_mutex);
+  return in_use;
+}
+
+ReplyReservation::ReplyReservation()
+: budget(get_reply_budget())
+, held(0)
+, max_held(0)
+{
+}
+
+ReplyReservation::~ReplyReservation()
+{
+  this->resize(0);
+}
+
+void
+ReplyReservation::resize(std::size_t n)
+{
+  if (n <= this->held)
+  {
+    if (n < this->held)
+    {
+      {
+        std::lock_guard<std::mutex> lock(budget_mutex);
+        in_use -= this->held - n;
+      }
+      this->held = n;
+      budget_released.notify_all();
+    }
+    return;
+  }
+
+  if (this->budget.per_call && n > this->budget.per_call)
+  {
+    throw ReplyTooLargeError(Glib::ustring::compose("%1 bytes buffered, per-call limit is %2", n, this->budget.per_call).raw());
+  }
+  if (this->budget.total && n > this->budget.total)
+  {
+    throw ReplyTooLargeError(Glib::ustring::compose("%1 bytes buffered, process limit is %2", n, this->budget.total).raw());
+  }
+
+  auto more = n - this->held;
+  std::unique_lock<std::mutex> lock(budget_mutex);
+  if (this->budget.total)
+  {
+    auto total = this->budget.total;
+    if (!budget_released.wait_for(lock, std::chrono::duration<double>(this->budget.max_wait), [more, total]() { return in_use + more <= total; }))
+    {
+      throw ReplyTooLargeError(Glib::ustring::compose("waited %1 s for %2 bytes of reply memory", this->budget.max_wait, more).raw());
+    }
+  }
+  in_use += more;
+  this->held = n;
+  this->max_held = std::max(this->max_held, n);
+}
+
+void
+reserve_reply_buffer(std::string& s, std::size_t n, const ReplyCharge& charge, std::size_t held)
+{
+  if (s.capacity() - s.size() >= n)
+  {
+    return;
+  }
+  auto capacity = std::max(s.size() + n, 2 * s.capacity());
+  if (charge)
+  {
+    charge(capacity + held);
+  }
+  s.reserve(capacity);
+}
+
+void
+set_rpc_memory_observer(RpcMemoryObserver observer)
+{
+  std::atomic_store(&memory_observer, observer ? std::make_shared<const RpcMemoryObserver>(std::move(observer)) : std::shared_ptr<const RpcMemoryObserver>());
+}
+
+std::shared_ptr<const RpcMemoryObserver>
+get_rpc_memory_observer()
+{
+  return std::atomic_load(&memory_observer);
+}
+}
@@ -0,0 +1,79 @@
+#ifndef _REPLY_BUDGET_HPP_
+#define _REPLY_BUDGET_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace Boinc
+{
+// Replies are read in pieces of this size, and every call reserves one piece before its
+// first read, so a nonzero limit below it would fail every call.
+const std::size_t REPLY_READ_SIZE = 64 * 1024;
+
+// Limits on memory used to buffer daemon replies; 0 disables a limit, and other values must
+// be at least REPLY_READ_SIZE. A call that would push the process-wide total over its limit
+// waits up to max_wait seconds for other calls to release memory, then fails with
+// ReplyTooLargeError like a call over per_call does.
+//
+// Only the receive buffers are charged: the read buffer and the raw reply text, or for the
+// streaming calls one partial entry and, with a capture writer installed, the reply copy
+// kept for it. Copies made while decoding (the reply without its XML
+// declaration, the DOM, the pieces of a parallel decode) are not, so the vector-returning
+// calls use several times their charge at peak.
+struct ReplyBudget
+{
+  std::size_t per_call = 0;
+  std::size_t total = 0;
+  double max_wait = 30;
+};
+
+// Called with the bytes a call's receive buffers will hold before they grow to hold them, so
+// the budget is charged, or the call fails, before the memory is allocated.
+typedef std::function<void(std::size_t)> ReplyCharge;
+
+// Makes room to append n bytes to a receive buffer. A larger capacity, at least double the
+// old one, is charged first together with the bytes the call holds elsewhere.
+void reserve_reply_buffer(std::string&, std::size_t, const ReplyCharge&, std::size_t = 0);
+
+// Throws std::invalid_argument for a nonzero limit below REPLY_READ_SIZE.
+void set_reply_budget(const ReplyBudget&);
+ReplyBudget get_reply_budget();
+std::size_t reply_memory_in_use();
+
+// Reply buffer memory held by one query_boinc_daemon() call, charged against the budget.
+class ReplyReservation
+{
+public:
+  ReplyReservation();
+  ReplyReservation(const ReplyReservation&) = delete;
+  ReplyReservation& operator=(const ReplyReservation&) = delete;
+  ~ReplyReservation();
+
+  void resize(std::size_t);
+  std::size_t size() const { return this->held; }
+  std::size_t peak() const { return this->max_held; }
+
+private:
+  ReplyBudget budget;
+  std::size_t held;
+  std::size_t max_held;
+};
+
+struct RpcMemoryReport
+{
+  std::string host;
+  int port;
+  std::size_t reply_bytes;
+  // Highest charge against the budget, which leaves out decoding copies.
+  std::size_t peak_buffer;
+};
+
+typedef std::function<void(const RpcMemoryReport&)> RpcMemoryObserver;
+
+// Called after every query_boinc_daemon() call, successful or not; pass nullptr to stop.
+void set_rpc_memory_observer(RpcMemoryObserver);
+std::shared_ptr<const RpcMemoryObserver> get_rpc_memory_observer();
+}
+#endif
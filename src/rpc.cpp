@@ -1,4 +1,7 @@
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include <boost/algorithm/string.hpp>
@@ -6,32 +9,131 @@
 #include <glibmm.h>
 #include <libxml++/libxml++.h>
 
+#include "capture.hpp"
 #include "exception_list.hpp"
 #include "models.hpp"
+#include "parse.hpp"
+#include "reply_budget.hpp"
+#include "scheduler.hpp"
 #include "util.hpp"
 
 #include "rpc.hpp"
 
 namespace Boinc
 {
+namespace
+{
+struct SessionRecorder
+{
+  std::shared_ptr<CaptureWriter> writer;
+  CaptureSession session;
 
-std::string
-compute_nonce_hash(std::string pass, std::string nonce)
+  // The auth2 hash next to the recorded nonce would allow an offline attack on the password.
+  void record(CaptureDirection direction, const std::string& data)
+  {
+    if (!this->writer)
+    {
+      return;
+    }
+    this->session.frames.push_back({direction, data});
+    auto& frame = this->session.frames.back().data;
+    auto begin = frame.find("<nonce_hash>");
+    auto end = frame.find("</nonce_hash>");
+    if (direction == CaptureDirection::REQUEST && begin != std::string::npos && end != std::string::npos && begin < end)
+    {
+      begin += std::strlen("<nonce_hash>");
+      frame.replace(begin, end - begin, "redacted");
+    }
+  }
+
+  ~SessionRecorder()
+  {
+    if (this->writer && !this->session.frames.empty())
+    {
+      try
+      {
+        this->writer->write(this->session);
+      }
+      catch (const std::exception& e)
+      {
+      }
+    }
+  }
+};
+
+struct MemoryReporter
 {
-  return Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_MD5, (nonce + pass));
+  RpcMemoryReport report;
+  ReplyReservation reservation;
+
+  ~MemoryReporter()
+  {
+    auto observer = get_rpc_memory_observer();
+    if (observer)
+    {
+      this->report.peak_buffer = this->reservation.peak();
+      try
+      {
+        (*observer)(this->report);
+      }
+      catch (const std::exception& e)
+      {
+      }
+    }
+  }
 };
 
+// Reads one '\3'-terminated reply in fixed-size pieces. The sink charges its buffers before
+// growing them and returns how many bytes it keeps buffered; the reservation covers that plus
+// the read buffer.
 void
-query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCallback request_writer, XMLCallback success_response_handler)
+receive_reply(boost::asio::ip::tcp::socket& socket, MemoryReporter& memory, ReplyChunkCallback sink)
+{
+  memory.reservation.resize(REPLY_READ_SIZE);
+  std::unique_ptr<char[]> chunk(new char[REPLY_READ_SIZE]);
+  ReplyCharge charge = [&memory](std::size_t buffered) { memory.reservation.resize(buffered + REPLY_READ_SIZE); };
+  while (true)
+  {
+    auto n = socket.read_some(boost::asio::buffer(chunk.get(), REPLY_READ_SIZE));
+    auto terminator = static_cast<const char*>(std::memchr(chunk.get(), '\3', n));
+    auto size = terminator ? terminator - chunk.get() : n;
+    memory.report.reply_bytes += size;
+    auto buffered = sink(chunk.get(), size, charge);
+    if (terminator)
+    {
+      memory.reservation.resize(buffered);
+      return;
+    }
+    memory.reservation.resize(buffered + REPLY_READ_SIZE);
+  }
+}
+
+void
+query(Glib::ustring host, int port, Glib::ustring password, XMLCallback request_writer, XMLCallback success_response_handler, ReplyCallback raw_response_handler, ReplyChunkCallback chunk_response_handler,
+  RequestPriority priority)
 {
   if (!request_writer)
   {
     success_response_handler = nullptr;
+    raw_response_handler = nullptr;
+    chunk_response_handler = nullptr;
   }
 
+  RpcScheduler::Slot slot(rpc_scheduler(), host.raw() + ':' + std::to_string(port), priority);
+
+  SessionRecorder recorder;
+  recorder.writer = get_capture_writer();
+  recorder.session.host = host.raw();
+  recorder.session.port = port;
+  recorder.session.started_at = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+  MemoryReporter memory;
+  memory.report = {host.raw(), port, 0, 0};
+
   boost::asio::io_service ios;
   boost::asio::ip::tcp::socket socket(ios);
-  socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string(host.raw()), port));
+  boost::asio::ip::tcp::resolver resolver(ios);
+  boost::asio::connect(socket, resolver.resolve(boost::asio::ip::tcp::resolver::query(host.raw(), std::to_string(port))));
 
   xmlpp::Document req_doc("1.0");
 
@@ -48,6 +150,7 @@ query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCall
     }
     auto req_string = boost::replace_all_copy(req_doc.write_to_string().raw(), "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", "");
     xml_clear_children(req_root);
+    recorder.record(CaptureDirection::REQUEST, req_string);
 
     req_string += '\3';
 #ifndef NDEBUG
@@ -55,21 +158,60 @@ query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCall
 #endif
     socket.write_some(boost::asio::buffer(req_string));
 
-    boost::asio::streambuf buf;
-    boost::asio::read_until(socket, buf, '\3');
-    auto recv_data =
-      boost::algorithm::trim_right_copy_if(std::string(boost::asio::buffers_begin(buf.data()), boost::asio::buffers_begin(buf.data()) + buf.size()), [](char v) -> bool { return v == '\3'; });
+    std::string recv_data;
+    if ((auth_complete && request_sent) && chunk_response_handler)
+    {
+      // The copy kept for the capture is charged along with what the handler buffers.
+      std::size_t handler_buffered = 0;
+      receive_reply(socket, memory, [&recorder, &recv_data, &handler_buffered, &chunk_response_handler](const char* data, std::size_t size, const ReplyCharge& charge) {
+        if (!recorder.writer)
+        {
+          return chunk_response_handler(data, size, charge);
+        }
+        reserve_reply_buffer(recv_data, size, charge, handler_buffered);
+        recv_data.append(data, size);
+        handler_buffered = chunk_response_handler(data, size, [&recv_data, &charge](std::size_t buffered) { charge(buffered + recv_data.capacity()); });
+        return handler_buffered + recv_data.capacity();
+      });
+      recorder.record(CaptureDirection::REPLY, recv_data);
+      return;
+    }
+
+    receive_reply(socket, memory, [&recv_data](const char* data, std::size_t size, const ReplyCharge& charge) {
+      reserve_reply_buffer(recv_data, size, charge);
+      recv_data.append(data, size);
+      return recv_data.capacity();
+    });
 #ifndef NDEBUG
     std::cout << recv_data << std::endl;
 #endif
 
-    auto rsp_doc = load_xml(boost::replace_all_copy(recv_data, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" ?>", ""));
-    auto root_node = rsp_doc->get_root_node();
-    if (root_node->get_name() != "boinc_gui_rpc_reply")
+    recorder.record(CaptureDirection::REPLY, recv_data);
+
+    if ((auth_complete && request_sent) && raw_response_handler)
     {
-      throw DataParseError("invalid response XML root node");
+      try
+      {
+        raw_response_handler(recv_data);
+      }
+      catch (const DaemonError&)
+      {
+        throw;
+      }
+      catch (const InvalidPasswordError&)
+      {
+        throw;
+      }
+      catch (const std::exception& e)
+      {
+        throw DataParseError(Glib::ustring::compose("%1 : %2", e.what(), recv_data).raw());
+      }
+      return;
     }
 
+    auto rsp_doc = load_reply(recv_data);
+    auto root_node = rsp_doc->get_root_node();
+
     bool auth_in_progress = false;
     bool done = false;
 
@@ -102,7 +244,7 @@ query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCall
       }
     }
 
-    if (done || (auth_complete && !success_response_handler))
+    if (done || (auth_complete && !success_response_handler && !raw_response_handler && !chunk_response_handler))
     {
       return;
     }
@@ -120,3 +262,28 @@ query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCall
   }
 }
 }
+
+std::string
+compute_nonce_hash(std::string pass, std::string nonce)
+{
+  return Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_MD5, (nonce + pass));
+};
+
+void
+query_boinc_daemon(Glib::ustring host, int port, Glib::ustring password, XMLCallback request_writer, XMLCallback success_response_handler, RequestPriority priority)
+{
+  query(host, port, password, request_writer, success_response_handler, nullptr, nullptr, priority);
+}
+
+void
+query_boinc_daemon_raw(Glib::ustring host, int port, Glib::ustring password, XMLCallback request_writer, ReplyCallback response_handler, RequestPriority priority)
+{
+  query(host, port, password, request_writer, nullptr, response_handler, nullptr, priority);
+}
+
+void
+query_boinc_daemon_stream(Glib::ustring host, int port, Glib::ustring password, XMLCallback request_writer, ReplyChunkCallback response_handler, RequestPriority priority)
+{
+  query(host, port, password, request_writer, nullptr, nullptr, response_handler, priority);
+}
+}
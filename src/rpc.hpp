@@ -1,15 +1,28 @@
 #ifndef _RPC_HPP_
 #define _RPC_HPP_
 
+#include <cstddef>
+#include <functional>
 #include <string>
 
 #include <glibmm.h>
 
+#include "reply_budget.hpp"
+#include "scheduler.hpp"
 #include "util.hpp"
 
 namespace Boinc
 {
+typedef std::function<void(const std::string&)> ReplyCallback;
+// Receives the final reply piece by piece and returns how many bytes it still buffers. A
+// handler that grows a buffer charges it first, e.g. through reserve_reply_buffer().
+// Unlike the other handlers, its exceptions reach the caller unwrapped, so user code it
+// runs can throw to stop early; decoding errors should be raised as DataParseError.
+typedef std::function<std::size_t(const char*, std::size_t, const ReplyCharge&)> ReplyChunkCallback;
+
 std::string compute_nonce_hash(std::string, std::string);
-void query_boinc_daemon(Glib::ustring, int, Glib::ustring, XMLCallback, XMLCallback = nullptr);
+void query_boinc_daemon(Glib::ustring, int, Glib::ustring, XMLCallback, XMLCallback = nullptr, RequestPriority = RequestPriority::BULK);
+void query_boinc_daemon_raw(Glib::ustring, int, Glib::ustring, XMLCallback, ReplyCallback, RequestPriority = RequestPriority::BULK);
+void query_boinc_daemon_stream(Glib::ustring, int, Glib::ustring, XMLCallback, ReplyChunkCallback, RequestPriority = RequestPriority::BULK);
 }
 #endif
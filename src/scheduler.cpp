@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "scheduler.hpp"
+
+namespace Boinc
+{
+namespace
+{
+// Slots held by the current thread, so a callback that calls the same daemon again does not wait on itself.
+thread_local std::vector<std::pair<RpcScheduler*, std::string>> held_slots;
+}
+
+RpcScheduler::Slot::Slot(RpcScheduler& scheduler, const std::string& daemon, RequestPriority priority)
+: scheduler(scheduler)
+, daemon(daemon)
+, nested(std::find(held_slots.begin(), held_slots.end(), std::make_pair(&scheduler, daemon)) != held_slots.end())
+{
+  if (!this->nested)
+  {
+    this->scheduler.acquire(this->daemon, priority);
+    held_slots.emplace_back(&this->scheduler, this->daemon);
+  }
+}
+
+RpcScheduler::Slot::~Slot()
+{
+  if (!this->nested)
+  {
+    held_slots.erase(std::find(held_slots.begin(), held_slots.end(), std::make_pair(&this->scheduler, this->daemon)));
+    this->scheduler.release(this->daemon);
+  }
+}
+
+RpcScheduler::RpcScheduler(std::size_t slots)
+: slots(slots)
+{
+}
+
+void
+RpcScheduler::set_slots_per_daemon(std::size_t n)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->slots = n;
+  }
+  this->cv.notify_all();
+}
+
+QueueStats
+RpcScheduler::stats(RequestPriority priority) const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->class_stats[static_cast<std::size_t>(priority)];
+}
+
+void
+RpcScheduler::acquire(const std::string& daemon, RequestPriority priority)
+{
+  auto c = static_cast<std::size_t>(priority);
+  auto interactive = static_cast<std::size_t>(RequestPriority::INTERACTIVE);
+  auto started = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  auto& d = this->daemons[daemon];
+  auto ticket = d.next_ticket[c]++;
+  auto& stats = this->class_stats[c];
+  stats.queued++;
+
+  this->cv.wait(lock, [this, &d, c, ticket, interactive]() {
+    return d.serving[c] == ticket && (this->slots == 0 || d.active < this->slots) && (c == interactive || d.serving[interactive] == d.next_ticket[interactive]);
+  });
+  d.serving[c]++;
+  d.active++;
+
+  auto wait = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  stats.queued--;
+  stats.requests++;
+  stats.total_wait += wait;
+  stats.max_wait = std::max(stats.max_wait, wait);
+
+  lock.unlock();
+  this->cv.notify_all();
+}
+
+void
+RpcScheduler::release(const std::string& daemon)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    auto it = this->daemons.find(daemon);
+    auto& d = it->second;
+    d.active--;
+    if (d.active == 0 && std::equal(d.serving, d.serving + CLASSES, d.next_ticket))
+    {
+      this->daemons.erase(it);
+    }
+  }
+  this->cv.notify_all();
+}
+
+RpcScheduler&
+rpc_scheduler()
+{
+  static RpcScheduler scheduler;
+  return scheduler;
+}
+}
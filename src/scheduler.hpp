@@ -0,0 +1,87 @@
+#ifndef _SCHEDULER_HPP_
+#define _SCHEDULER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Boinc
+{
+enum class RequestPriority
+{
+  INTERACTIVE,
+  BULK
+};
+
+struct QueueStats
+{
+  std::size_t requests = 0;
+  std::size_t queued = 0;
+  double total_wait = 0;
+  double max_wait = 0;
+
+  double mean_wait() const { return this->requests ? this->total_wait / this->requests : 0; }
+};
+
+// Admits RPCs to each daemon (host:port) a limited number at a time; 0 slots, the default,
+// admits every request at once. Every priority class has its own FIFO queue per daemon,
+// and a BULK request is admitted only while no INTERACTIVE request is waiting for the
+// same daemon. Slots are held for one RPC, so a batch of BULK calls yields to interactive
+// ones between RPCs.
+//
+// A slot stays held while the RPC's reply handlers run. An RPC made from inside a handler
+// on the same thread reuses the slot instead of waiting; one made from another thread that
+// the handler waits on deadlocks once the daemon's slots are all taken.
+class RpcScheduler
+{
+public:
+  class Slot
+  {
+  public:
+    Slot(RpcScheduler&, const std::string&, RequestPriority);
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+    ~Slot();
+
+  private:
+    RpcScheduler& scheduler;
+    std::string daemon;
+    bool nested;
+  };
+
+  explicit RpcScheduler(std::size_t = 0);
+  RpcScheduler(const RpcScheduler&) = delete;
+  RpcScheduler& operator=(const RpcScheduler&) = delete;
+
+  void set_slots_per_daemon(std::size_t);
+  QueueStats stats(RequestPriority) const;
+
+private:
+  static const std::size_t CLASSES = 2;
+
+  struct Daemon
+  {
+    std::size_t active = 0;
+    std::uint64_t next_ticket[CLASSES] = {0, 0};
+    std::uint64_t serving[CLASSES] = {0, 0};
+  };
+
+  void acquire(const std::string&, RequestPriority);
+  void release(const std::string&);
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  std::size_t slots;
+  std::unordered_map<std::string, Daemon> daemons;
+  QueueStats class_stats[CLASSES];
+};
+
+// Process-wide scheduler used by query_boinc_daemon(). Unlimited by default; call
+// set_slots_per_daemon() to make calls to a daemon queue by priority.
+RpcScheduler& rpc_scheduler();
+}
+#endif
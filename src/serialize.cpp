@@ -0,0 +1,440 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <glibmm.h>
+
+#include "fields.hpp"
+#include "models.hpp"
+
+#include "serialize.hpp"
+
+namespace Boinc
+{
+namespace
+{
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+void
+put_literal(OutputBuffer& out, const char* s)
+{
+  out.put(s, std::strlen(s));
+}
+
+void
+put_integer(OutputBuffer& out, std::int64_t v)
+{
+  char tmp[24];
+  char* p = tmp + sizeof(tmp);
+  auto u = v < 0 ? 0 - static_cast<std::uint64_t>(v) : static_cast<std::uint64_t>(v);
+  do
+  {
+    *--p = static_cast<char>('0' + u % 10);
+    u /= 10;
+  } while (u);
+  if (v < 0)
+  {
+    *--p = '-';
+  }
+  out.put(p, tmp + sizeof(tmp) - p);
+}
+
+void
+put_real(OutputBuffer& out, double v)
+{
+  char tmp[32];
+  out.put(tmp, format_real(v, tmp));
+}
+
+void
+put_json_string(OutputBuffer& out, const std::string& s)
+{
+  out.put('"');
+  auto run = s.data();
+  auto end = s.data() + s.size();
+  for (auto p = run; p != end; p++)
+  {
+    auto c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+    out.put(run, p - run);
+    run = p + 1;
+    switch (c)
+    {
+    case '"':
+      put_literal(out, "\\\"");
+      break;
+    case '\\':
+      put_literal(out, "\\\\");
+      break;
+    case '\n':
+      put_literal(out, "\\n");
+      break;
+    case '\r':
+      put_literal(out, "\\r");
+      break;
+    case '\t':
+      put_literal(out, "\\t");
+      break;
+    default:
+      put_literal(out, "\\u00");
+      out.put(HEX_DIGITS[c >> 4]);
+      out.put(HEX_DIGITS[c & 0xf]);
+    }
+  }
+  out.put(run, end - run);
+  out.put('"');
+}
+
+void
+put_line_string(OutputBuffer& out, const std::string& s)
+{
+  auto run = s.data();
+  auto end = s.data() + s.size();
+  for (auto p = run; p != end; p++)
+  {
+    if (*p != '"' && *p != '\\' && *p != '\n')
+    {
+      continue;
+    }
+    out.put(run, p - run);
+    run = p + 1;
+    out.put('\\');
+    out.put(*p == '\n' ? 'n' : *p);
+  }
+  out.put(run, end - run);
+}
+
+struct JsonFields
+{
+  OutputBuffer& out;
+  bool first;
+
+  template <typename F>
+  void operator()(const char* name, FieldKind, const std::experimental::optional<F>& field)
+  {
+    if (!field)
+    {
+      return;
+    }
+    if (!this->first)
+    {
+      this->out.put(',');
+    }
+    this->first = false;
+    this->out.put('"');
+    put_literal(this->out, name);
+    put_literal(this->out, "\":");
+    this->value(*field);
+  }
+
+  void value(int v) { put_integer(this->out, v); }
+
+  void value(bool v) { put_literal(this->out, v ? "true" : "false"); }
+
+  void value(double v)
+  {
+    if (std::isfinite(v))
+    {
+      put_real(this->out, v);
+    }
+    else
+    {
+      put_literal(this->out, "null");
+    }
+  }
+
+  void value(const Glib::ustring& v) { put_json_string(this->out, v.raw()); }
+
+  void value(const std::vector<Glib::ustring>& v)
+  {
+    this->out.put('[');
+    for (std::size_t i = 0; i < v.size(); i++)
+    {
+      if (i)
+      {
+        this->out.put(',');
+      }
+      put_json_string(this->out, v[i].raw());
+    }
+    this->out.put(']');
+  }
+};
+
+struct LineFields
+{
+  OutputBuffer& out;
+  std::size_t count;
+
+  template <typename F>
+  void operator()(const char* name, FieldKind, const std::experimental::optional<F>& field)
+  {
+    if (!field || !this->representable(*field))
+    {
+      return;
+    }
+    this->out.put(this->count++ ? ',' : ' ');
+    put_literal(this->out, name);
+    this->out.put('=');
+    this->value(*field);
+  }
+
+  template <typename F>
+  bool representable(const F&)
+  {
+    return true;
+  }
+
+  bool representable(double v) { return std::isfinite(v); }
+
+  void value(int v)
+  {
+    put_integer(this->out, v);
+    this->out.put('i');
+  }
+
+  void value(bool v) { put_literal(this->out, v ? "true" : "false"); }
+
+  void value(double v) { put_real(this->out, v); }
+
+  void value(const Glib::ustring& v)
+  {
+    this->out.put('"');
+    put_line_string(this->out, v.raw());
+    this->out.put('"');
+  }
+
+  void value(const std::vector<Glib::ustring>& v)
+  {
+    this->out.put('"');
+    for (std::size_t i = 0; i < v.size(); i++)
+    {
+      if (i)
+      {
+        this->out.put(',');
+      }
+      put_line_string(this->out, v[i].raw());
+    }
+    this->out.put('"');
+  }
+};
+
+// Tag values escape commas, spaces and equals signs.
+void
+put_tag_value(OutputBuffer& out, const std::string& s)
+{
+  for (auto c : s)
+  {
+    if (c == ',' || c == ' ' || c == '=')
+    {
+      out.put('\\');
+    }
+    out.put(c);
+  }
+}
+
+void
+put_measurement(OutputBuffer& out, const char* measurement, const char* tags)
+{
+  for (auto p = measurement; *p; p++)
+  {
+    if (*p == ',' || *p == ' ')
+    {
+      out.put('\\');
+    }
+    out.put(*p);
+  }
+  if (tags && *tags)
+  {
+    out.put(',');
+    put_literal(out, tags);
+  }
+}
+
+// Writes nothing for a record without any representable field.
+template <typename T>
+void
+put_line(OutputBuffer& out, const char* measurement, const char* tags, const T& entry, std::int64_t timestamp)
+{
+  auto mark = out.size();
+  put_measurement(out, measurement, tags);
+
+  LineFields fields{out, 0};
+  visit_fields(entry, fields);
+  if (fields.count == 0)
+  {
+    out.truncate(mark);
+    return;
+  }
+
+  if (timestamp)
+  {
+    out.put(' ');
+    put_integer(out, timestamp);
+  }
+  out.put('\n');
+}
+
+// Models with nested entries add them after their own fields.
+template <typename T>
+void
+put_json_children(OutputBuffer&, const T&, bool)
+{
+}
+
+void
+put_json_children(OutputBuffer& out, const DiskUsage& entry, bool first)
+{
+  if (!first)
+  {
+    out.put(',');
+  }
+  put_literal(out, "\"projects\":[");
+  for (std::size_t i = 0; i < entry.projects.size(); i++)
+  {
+    if (i)
+    {
+      out.put(',');
+    }
+    out.put('{');
+    visit_fields(entry.projects[i], JsonFields{out, true});
+    out.put('}');
+  }
+  out.put(']');
+}
+
+template <typename T>
+void
+put_child_lines(OutputBuffer&, const char*, const T&, const char*, std::int64_t)
+{
+}
+
+// One line per project, tagged with its master URL.
+void
+put_child_lines(OutputBuffer& out, const char* measurement, const DiskUsage& entry, const char* tags, std::int64_t timestamp)
+{
+  for (auto& project : entry.projects)
+  {
+    if (!project.disk_usage || !std::isfinite(*project.disk_usage))
+    {
+      continue;
+    }
+    put_measurement(out, measurement, tags);
+    if (project.master_url && !project.master_url->empty())
+    {
+      put_literal(out, ",project=");
+      put_tag_value(out, project.master_url->raw());
+    }
+    put_literal(out, " disk_usage=");
+    put_real(out, *project.disk_usage);
+    if (timestamp)
+    {
+      out.put(' ');
+      put_integer(out, timestamp);
+    }
+    out.put('\n');
+  }
+}
+}
+
+// printf honours LC_NUMERIC, so a decimal comma from the process locale is mapped back to a point.
+std::size_t
+format_real(double v, char (&tmp)[32])
+{
+  auto n = std::snprintf(tmp, sizeof(tmp), "%.15g", v);
+  if (std::strtod(tmp, nullptr) != v)
+  {
+    n = std::snprintf(tmp, sizeof(tmp), "%.17g", v);
+  }
+  for (int i = 0; i < n; i++)
+  {
+    if (tmp[i] == ',')
+    {
+      tmp[i] = '.';
+    }
+  }
+  return n;
+}
+
+OutputBuffer::OutputBuffer(char* data, std::size_t capacity)
+: buf(data)
+, cap(capacity)
+, len(0)
+, overflow(false)
+{
+}
+
+void
+OutputBuffer::put(const char* s, std::size_t n)
+{
+  if (this->cap - this->len < n)
+  {
+    this->overflow = true;
+    return;
+  }
+  std::memcpy(this->buf + this->len, s, n);
+  this->len += n;
+}
+
+template <typename T>
+bool
+write_json(OutputBuffer& out, const T& entry)
+{
+  auto mark = out.size();
+  out.put('{');
+  JsonFields fields{out, true};
+  visit_fields(entry, fields);
+  put_json_children(out, entry, fields.first);
+  out.put('}');
+
+  if (out.overflowed())
+  {
+    out.truncate(mark);
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool
+write_line_protocol(OutputBuffer& out, const char* measurement, const T& entry, const char* tags, std::int64_t timestamp)
+{
+  auto mark = out.size();
+  put_line(out, measurement, tags, entry, timestamp);
+  put_child_lines(out, measurement, entry, tags, timestamp);
+
+  if (out.overflowed())
+  {
+    out.truncate(mark);
+    return false;
+  }
+  return true;
+}
+
+template bool write_json(OutputBuffer&, const VersionInfo&);
+template bool write_json(OutputBuffer&, const HostInfo&);
+template bool write_json(OutputBuffer&, const ProjectInfo&);
+template bool write_json(OutputBuffer&, const AccountManagerInfo&);
+template bool write_json(OutputBuffer&, const Message&);
+template bool write_json(OutputBuffer&, const Result&);
+template bool write_json(OutputBuffer&, const CcStatus&);
+template bool write_json(OutputBuffer&, const FileTransfer&);
+template bool write_json(OutputBuffer&, const ProjectDiskUsage&);
+template bool write_json(OutputBuffer&, const DiskUsage&);
+
+template bool write_line_protocol(OutputBuffer&, const char*, const VersionInfo&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const HostInfo&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const ProjectInfo&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const AccountManagerInfo&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const Message&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const Result&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const CcStatus&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const FileTransfer&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const ProjectDiskUsage&, const char*, std::int64_t);
+template bool write_line_protocol(OutputBuffer&, const char*, const DiskUsage&, const char*, std::int64_t);
+}
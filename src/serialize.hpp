@@ -0,0 +1,88 @@
+#ifndef _SERIALIZE_HPP_
+#define _SERIALIZE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "models.hpp"
+
+namespace Boinc
+{
+// Fixed-capacity output over caller-owned memory. Writes past the capacity are
+// dropped and mark the buffer as overflowed instead of growing it.
+class OutputBuffer
+{
+public:
+  OutputBuffer(char*, std::size_t);
+
+  const char* data() const { return this->buf; }
+  std::size_t size() const { return this->len; }
+  std::size_t capacity() const { return this->cap; }
+  bool overflowed() const { return this->overflow; }
+  void clear() { this->truncate(0); }
+  void truncate(std::size_t n)
+  {
+    this->len = n < this->len ? n : this->len;
+    this->overflow = false;
+  }
+
+  void put(char c)
+  {
+    if (this->len < this->cap)
+    {
+      this->buf[this->len++] = c;
+    }
+    else
+    {
+      this->overflow = true;
+    }
+  }
+  void put(const char*, std::size_t);
+
+private:
+  char* buf;
+  std::size_t cap;
+  std::size_t len;
+  bool overflow;
+};
+
+// Shortest of %.15g / %.17g that round-trips v, always with '.' as the decimal point, for
+// finite v. Returns the length written to the buffer, which is not NUL-terminated.
+std::size_t format_real(double, char (&)[32]);
+
+// Append one record as a JSON object, skipping absent fields; DiskUsage::projects becomes a
+// "projects" array. Returns false and leaves the buffer as it was when the record does not
+// fit. Never allocates.
+template <typename T>
+bool write_json(OutputBuffer&, const T&);
+
+// Append one InfluxDB line: "measurement[,tags] field=value,... [timestamp]\n". Tags are
+// passed through pre-formatted; a zero timestamp (nanoseconds) is left for the server to fill.
+// Records without any present field produce no line. DiskUsage adds one line per project
+// with a disk_usage field, tagged project=<master_url>. Same overflow contract as write_json.
+template <typename T>
+bool write_line_protocol(OutputBuffer&, const char*, const T&, const char* = nullptr, std::int64_t = 0);
+
+extern template bool write_json(OutputBuffer&, const VersionInfo&);
+extern template bool write_json(OutputBuffer&, const HostInfo&);
+extern template bool write_json(OutputBuffer&, const ProjectInfo&);
+extern template bool write_json(OutputBuffer&, const AccountManagerInfo&);
+extern template bool write_json(OutputBuffer&, const Message&);
+extern template bool write_json(OutputBuffer&, const Result&);
+extern template bool write_json(OutputBuffer&, const CcStatus&);
+extern template bool write_json(OutputBuffer&, const FileTransfer&);
+extern template bool write_json(OutputBuffer&, const ProjectDiskUsage&);
+extern template bool write_json(OutputBuffer&, const DiskUsage&);
+
+extern template bool write_line_protocol(OutputBuffer&, const char*, const VersionInfo&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const HostInfo&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const ProjectInfo&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const AccountManagerInfo&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const Message&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const Result&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const CcStatus&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const FileTransfer&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const ProjectDiskUsage&, const char*, std::int64_t);
+extern template bool write_line_protocol(OutputBuffer&, const char*, const DiskUsage&, const char*, std::int64_t);
+}
+#endif
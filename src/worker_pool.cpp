@@ -0,0 +1,68 @@
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "worker_pool.hpp"
+
+namespace Boinc
+{
+WorkerPool::WorkerPool(std::size_t n)
+: stopping(false)
+{
+  for (std::size_t i = 0; i < (n ? n : 1); i++)
+  {
+    this->threads.emplace_back([this]() { this->run(); });
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+  }
+  this->cv.notify_all();
+  for (auto& t : this->threads)
+  {
+    t.join();
+  }
+}
+
+void
+WorkerPool::submit(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->queue.push_back(std::move(task));
+  }
+  this->cv.notify_one();
+}
+
+void
+WorkerPool::run()
+{
+  while (true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->cv.wait(lock, [this]() { return this->stopping || !this->queue.empty(); });
+      if (this->queue.empty())
+      {
+        return;
+      }
+      task = std::move(this->queue.front());
+      this->queue.pop_front();
+    }
+    task();
+  }
+}
+
+WorkerPool&
+shared_worker_pool()
+{
+  static WorkerPool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+}
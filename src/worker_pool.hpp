@@ -0,0 +1,38 @@
+#ifndef _WORKER_POOL_HPP_
+#define _WORKER_POOL_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Boinc
+{
+class WorkerPool
+{
+public:
+  explicit WorkerPool(std::size_t);
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool();
+
+  std::size_t size() const { return this->threads.size(); }
+  void submit(std::function<void()>);
+
+private:
+  void run();
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> queue;
+  bool stopping;
+  std::vector<std::thread> threads;
+};
+
+// Process-wide pool with one worker per hardware thread, created on first use.
+WorkerPool& shared_worker_pool();
+}
+#endif
@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exception_list.hpp"
+#include "history.hpp"
+
+using namespace Boinc;
+
+namespace
+{
+int failures = 0;
+
+void
+check(bool ok, const std::string& what)
+{
+  if (!ok)
+  {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+std::string
+temp_path()
+{
+  char path[] = "/tmp/history_test_XXXXXX";
+  auto fd = ::mkstemp(path);
+  ::close(fd);
+  std::remove(path);
+  return path;
+}
+
+std::size_t
+file_size(const std::string& path)
+{
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+Message
+make_message(int i)
+{
+  Message m;
+  m.name = Glib::ustring("project" + std::to_string(i % 2));
+  m.priority = i % 3;
+  m.msg_number = i;
+  m.body = Glib::ustring("body " + std::to_string(i));
+  m.dt = 1500000000.5 + i;
+  return m;
+}
+
+bool
+same_message(const Message& a, const Message& b)
+{
+  return a.name == b.name && a.priority == b.priority && a.msg_number == b.msg_number && a.body == b.body && a.dt == b.dt;
+}
+
+void
+test_round_trip()
+{
+  auto path = temp_path();
+  std::vector<Message> written;
+  {
+    HistoryWriter<Message> writer(path);
+    for (int i = 0; i < 300; i++)
+    {
+      written.push_back(make_message(i));
+      writer.append(written.back(), 1500000000000000 + i * 1000000LL);
+    }
+  }
+  {
+    // Reopening starts a new dictionary; blocks before it must still decode.
+    HistoryWriter<Message> writer(path);
+    std::vector<Message> batch{make_message(300), make_message(301), Message()};
+    written.insert(written.end(), batch.begin(), batch.end());
+    writer.append(batch, 1500000300000000);
+  }
+
+  HistoryReader<Message> reader(path);
+  check(reader.size() == 301, "block count after reopen");
+  std::vector<Message> read;
+  reader.for_each([&read](std::int64_t, const Message& m) { read.push_back(m); });
+  check(read.size() == written.size(), "row count after reopen");
+  for (std::size_t i = 0; i < read.size() && i < written.size(); i++)
+  {
+    check(same_message(read[i], written[i]), "row " + std::to_string(i));
+  }
+  auto block = reader.read(257);
+  check(block.size() == 1 && same_message(block[0], written[257]), "random access past a dictionary restart");
+  check(reader.block_time(10) == 1500000010000000, "block time");
+  std::remove(path.c_str());
+}
+
+void
+test_dictionary_shared_across_blocks()
+{
+  auto path = temp_path();
+  HistoryWriter<HostInfo> writer(path);
+  HostInfo host;
+  host.domain_name = Glib::ustring("a-rather-long-host-name.example.org");
+  host.p_model = Glib::ustring("Intel(R) Core(TM) i7-8700 CPU @ 3.20GHz");
+  host.p_features = Glib::ustring("fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36");
+  writer.append(host, 1500000000000000);
+  auto first = file_size(path);
+  writer.append(host, 1500000060000000);
+  auto second = file_size(path) - first;
+  auto strings = host.domain_name->raw().size() + host.p_model->raw().size() + host.p_features->raw().size();
+  check(first - second >= strings, "repeated strings are not stored again");
+
+  HistoryReader<HostInfo> reader(path);
+  auto rows = reader.read(1);
+  check(rows.size() == 1 && rows[0].p_features == host.p_features && rows[0].domain_name == host.domain_name, "second block decodes");
+  std::remove(path.c_str());
+}
+
+void
+test_truncated_block()
+{
+  auto path = temp_path();
+  {
+    HistoryWriter<Message> writer(path);
+    writer.append(make_message(0), 1500000000000000);
+    writer.append(make_message(1), 1500000001000000);
+  }
+  auto complete = file_size(path);
+  {
+    HistoryWriter<Message> writer(path);
+    writer.append(make_message(2), 1500000002000000);
+  }
+  check(::truncate(path.c_str(), file_size(path) - 3) == 0, "truncate");
+
+  {
+    HistoryReader<Message> reader(path);
+    check(reader.size() == 2, "reader ignores a truncated block");
+  }
+  {
+    HistoryWriter<Message> writer(path);
+    check(file_size(path) == complete, "writer drops a truncated block");
+    writer.append(make_message(3), 1500000003000000);
+  }
+  HistoryReader<Message> reader(path);
+  check(reader.size() == 3, "append after a truncated block");
+  auto rows = reader.read(2);
+  check(rows.size() == 1 && same_message(rows[0], make_message(3)), "block appended after truncation decodes");
+  std::remove(path.c_str());
+}
+}
+
+int
+main()
+{
+  test_round_trip();
+  test_dictionary_shared_across_blocks();
+  test_truncated_block();
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "message_index.hpp"
+#include "parse.hpp"
+
+using namespace Boinc;
+
+namespace
+{
+int failures = 0;
+
+void
+check(bool ok, const std::string& what)
+{
+  if (!ok)
+  {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+void
+test_parsed_reply_by_project()
+{
+  std::string reply = "<boinc_gui_rpc_reply>\n<msgs>\n"
+                      "<msg>\n <project>Einstein@Home</project>\n <pri>1</pri>\n <seqno>1</seqno>\n <body>\nScheduler request completed\n</body>\n <time>1500000000</time>\n</msg>\n"
+                      "<msg>\n <project></project>\n <pri>1</pri>\n <seqno>2</seqno>\n <body>\nStarting BOINC client\n</body>\n <time>1500000001</time>\n</msg>\n"
+                      "</msgs>\n</boinc_gui_rpc_reply>\n";
+  std::vector<Message> messages;
+  decode_reply_entries(reply, "msgs", "msg", parse_message, messages);
+  check(messages.size() == 2 && messages[0].name && *messages[0].name == "Einstein@Home", "parse_message reads <project>");
+
+  MessageIndex index;
+  index.add("host", messages);
+  MessageQuery query;
+  query.project = std::string("Einstein@Home");
+  auto hits = index.search(query);
+  check(hits.size() == 1 && hits[0].message.msg_number == 1, "parsed message found by project");
+}
+
+Message
+make_message(const char* project, int priority, int seqno, const char* body, double dt)
+{
+  Message m;
+  m.name = Glib::ustring(project);
+  m.priority = priority;
+  m.msg_number = seqno;
+  m.body = Glib::ustring(body);
+  m.dt = dt;
+  return m;
+}
+
+std::vector<Message>
+sample_messages()
+{
+  return {make_message("Einstein@Home", 1, 1, "Scheduler request completed: got 2 new tasks", 100),
+    make_message("Rosetta@home", 1, 2, "Scheduler request failed: HTTP error", 200),
+    make_message("Einstein@Home", 2, 3, "Computation for task x finished", 300),
+    make_message("Rosetta@home", 3, 4, "Project communication failed: attempting access to reference site", 400)};
+}
+
+void
+test_queries()
+{
+  MessageIndex index;
+  index.add("a", sample_messages());
+
+  MessageQuery query;
+  query.text = "SCHEDULER request";
+  auto hits = index.search(query);
+  check(hits.size() == 2 && hits[0].message.msg_number == 2 && hits[1].message.msg_number == 1, "phrase matches case-insensitively, newest first");
+
+  query.text = "request scheduler";
+  check(index.search(query).empty(), "phrase words must be consecutive and in order");
+
+  query = MessageQuery();
+  query.project = std::string("Rosetta@home");
+  hits = index.search(query);
+  check(hits.size() == 2 && hits[0].message.msg_number == 4 && hits[0].host == "a", "project filter");
+
+  query = MessageQuery();
+  query.priority = 1;
+  check(index.search(query).size() == 2, "priority filter");
+
+  query = MessageQuery();
+  query.from = 150;
+  query.to = 300;
+  hits = index.search(query);
+  check(hits.size() == 2 && hits[0].message.msg_number == 3 && hits[1].message.msg_number == 2, "time range");
+
+  query.text = "failed";
+  query.project = std::string("Rosetta@home");
+  query.priority = 1;
+  hits = index.search(query);
+  check(hits.size() == 1 && hits[0].message.msg_number == 2, "combined filters");
+
+  query.project = std::string("unknown");
+  check(index.search(query).empty(), "unknown project");
+}
+
+void
+test_repeated_add()
+{
+  MessageIndex index;
+  index.add("a", sample_messages());
+  index.add("a", sample_messages());
+  check(index.size() == 4, "messages already added for a host are skipped");
+  check(index.last_msg_number("a") && *index.last_msg_number("a") == 4, "last message number");
+
+  index.add("b", sample_messages());
+  check(index.size() == 8, "numbering is per host");
+
+  index.forget("a");
+  check(!index.last_msg_number("a"), "forgotten host");
+  index.add("a", make_message("Einstein@Home", 1, 1, "Starting BOINC client", 500));
+  check(index.size() == 9, "forgotten host numbers from the start again");
+}
+
+void
+test_eviction()
+{
+  MessageIndex index(8);
+  for (int i = 1; i <= 11; i++)
+  {
+    index.add("a", make_message(i % 2 ? "Einstein@Home" : "Rosetta@home", 1, i, i == 1 ? "first entry" : "other entry", i));
+  }
+  check(index.size() == 8, "oldest messages dropped past the cap");
+
+  MessageQuery query;
+  query.text = "first";
+  check(index.search(query).empty(), "dropped message is not found");
+  query.text = "entry";
+  query.limit = 20;
+  auto hits = index.search(query);
+  check(hits.size() == 8 && hits.front().message.msg_number == 11 && hits.back().message.msg_number == 4, "remaining messages keep their order");
+  check(hits.back().message.body && *hits.back().message.body == "other entry", "remaining bodies survive re-indexing");
+  query = MessageQuery();
+  query.project = std::string("Rosetta@home");
+  check(index.search(query).size() == 4, "project lists rebuilt");
+
+  index.add("a", make_message("Einstein@Home", 1, 2, "stale entry", 11));
+  check(index.size() == 8, "dropped messages are not added again");
+}
+}
+
+int
+main()
+{
+  test_parsed_reply_by_project();
+  test_queries();
+  test_repeated_add();
+  test_eviction();
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
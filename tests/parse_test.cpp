@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "exception_list.hpp"
+#include "parse.hpp"
+#include "reply_budget.hpp"
+
+using namespace Boinc;
+
+namespace
+{
+int failures = 0;
+
+void
+check(bool ok, const std::string& what)
+{
+  if (!ok)
+  {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+std::string
+make_reply()
+{
+  std::string reply = "<?xml version=\"1.0\" encoding=\"ISO-8859-1\" ?>\n<boinc_gui_rpc_reply>\n<msgs>\n";
+  for (int i = 0; reply.size() < 3 * REPLY_READ_SIZE; i++)
+  {
+    auto n = std::to_string(i);
+    reply += "<msg>\n <project>p" + n + "</project>\n <pri>" + std::to_string(i % 3) + "</pri>\n <seqno>" + n + "</seqno>\n";
+    reply += " <body><![CDATA[body " + n + " </msg> <!-- ]]></body>\n";
+    reply += " <!-- <msg> " + n + " -->\n";
+    reply += " <time>" + std::to_string(1500000000 + i) + "</time>\n</msg>\n";
+    reply += "<other a=\"1>0\"><msg/></other>\n";
+  }
+  reply += "</msgs>\n</boinc_gui_rpc_reply>\n";
+  return reply;
+}
+
+// Feeds the reply in REPLY_READ_SIZE pieces, as query_boinc_daemon_stream() reads it, after a
+// first piece of the given size, so that a read boundary lands at first + k * REPLY_READ_SIZE.
+std::vector<Message>
+stream_messages(const std::string& reply, std::size_t first)
+{
+  std::vector<Message> v;
+  ReplyEntryStream stream("msgs", "msg", [&v](xmlpp::Node* n) { v.push_back(parse_message(n)); });
+  for (std::size_t pos = 0; pos < reply.size();)
+  {
+    auto size = std::min(pos == 0 ? first : REPLY_READ_SIZE, reply.size() - pos);
+    stream.feed(reply.data() + pos, size);
+    pos += size;
+  }
+  stream.finish();
+  return v;
+}
+
+bool
+same_messages(const std::vector<Message>& a, const std::vector<Message>& b)
+{
+  if (a.size() != b.size())
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.size(); i++)
+  {
+    if (a[i].name != b[i].name || a[i].msg_number != b[i].msg_number || a[i].priority != b[i].priority || a[i].body != b[i].body || a[i].dt != b[i].dt)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+test_split_constructs()
+{
+  auto reply = make_reply();
+  std::vector<Message> expected;
+  set_parallel_decode_threshold(std::numeric_limits<std::size_t>::max());
+  decode_reply_entries(reply, "msgs", "msg", parse_message, expected);
+  check(expected.size() > 100, "reply has entries");
+
+  // Put a read boundary at every byte of one of each construct past the first read.
+  for (auto marker : {"<msg>", "</msg>", "<![CDATA[", "]]>", "<!--", "-->", "<other a=\"1>0\">", "<msg/>", "<time>"})
+  {
+    auto at = reply.find(marker, REPLY_READ_SIZE);
+    for (std::size_t k = at; k <= at + std::string(marker).size(); k++)
+    {
+      auto first = k % REPLY_READ_SIZE ? k % REPLY_READ_SIZE : REPLY_READ_SIZE;
+      check(same_messages(stream_messages(reply, first), expected), std::string("read boundary inside ") + marker + " at " + std::to_string(k));
+    }
+  }
+  check(same_messages(stream_messages(reply, 1), expected), "one-byte first read");
+}
+
+void
+test_find_reply_entries()
+{
+  auto reply = make_reply();
+  std::vector<Message> expected;
+  set_parallel_decode_threshold(std::numeric_limits<std::size_t>::max());
+  decode_reply_entries(reply, "msgs", "msg", parse_message, expected);
+
+  std::vector<EntryRange> entries;
+  check(find_reply_entries(reply, "msgs", "msg", entries), "find_reply_entries splits the reply");
+  check(entries.size() == expected.size(), "find_reply_entries skips nested and commented entries");
+
+  std::vector<Message> parallel;
+  set_parallel_decode_threshold(0);
+  decode_reply_entries(reply, "msgs", "msg", parse_message, parallel);
+  check(same_messages(parallel, expected), "parallel decode matches DOM decode");
+
+  entries.clear();
+  check(!find_reply_entries("<boinc_gui_rpc_reply><error>x</error></boinc_gui_rpc_reply>", "msgs", "msg", entries), "error reply is not split");
+  check(!find_reply_entries("<boinc_gui_rpc_reply><msgs><msg>", "msgs", "msg", entries), "truncated reply is not split");
+}
+
+void
+test_split_errors()
+{
+  auto feed_split = [](const std::string& reply, std::size_t k) {
+    ReplyEntryStream stream("msgs", "msg", [](xmlpp::Node*) {});
+    stream.feed(reply.data(), k);
+    stream.feed(reply.data() + k, reply.size() - k);
+    stream.finish();
+  };
+
+  std::string padding(REPLY_READ_SIZE, ' ');
+  std::string error_reply = "<boinc_gui_rpc_reply>" + padding + "<error>no such project</error></boinc_gui_rpc_reply>";
+  std::string auth_reply = "<boinc_gui_rpc_reply>" + padding + "<unauthorized/></boinc_gui_rpc_reply>";
+  std::string truncated = "<boinc_gui_rpc_reply><msgs>" + padding + "<msg><body>x</bo";
+  for (auto k = REPLY_READ_SIZE; k < REPLY_READ_SIZE + 40; k++)
+  {
+    auto what = " split at " + std::to_string(k);
+    try
+    {
+      feed_split(error_reply, k);
+      check(false, "error reply" + what);
+    }
+    catch (const DaemonError& e)
+    {
+      check(std::string(e.what()).find("no such project") != std::string::npos, "error text" + what);
+    }
+    try
+    {
+      feed_split(auth_reply, k);
+      check(false, "unauthorized reply" + what);
+    }
+    catch (const InvalidPasswordError&)
+    {
+    }
+    try
+    {
+      feed_split(truncated, k);
+      check(false, "truncated reply" + what);
+    }
+    catch (const DataParseError&)
+    {
+    }
+  }
+}
+
+void
+test_feed_charges()
+{
+  auto reply = make_reply();
+  std::size_t charged = 0;
+  std::size_t count = 0;
+  bool covered = true;
+  ReplyEntryStream stream("msgs", "msg", [&count](xmlpp::Node*) { count++; });
+  for (std::size_t pos = 0; pos < reply.size(); pos += REPLY_READ_SIZE)
+  {
+    auto size = std::min(REPLY_READ_SIZE, reply.size() - pos);
+    auto buffered = stream.feed(reply.data() + pos, size, [&charged](std::size_t n) { charged = std::max(charged, n); });
+    covered = covered && buffered <= charged;
+  }
+  stream.finish();
+  check(count > 100 && covered, "partial entry buffer is charged before it grows");
+
+  ReplyEntryStream refused("msgs", "msg", [](xmlpp::Node*) {});
+  bool thrown = false;
+  try
+  {
+    refused.feed(reply.data(), REPLY_READ_SIZE, [](std::size_t) { throw ReplyTooLargeError("over budget"); });
+  }
+  catch (const ReplyTooLargeError&)
+  {
+    thrown = true;
+  }
+  check(thrown, "refused charge stops the feed");
+}
+}
+
+int
+main()
+{
+  test_split_constructs();
+  test_find_reply_entries();
+  test_split_errors();
+  test_feed_charges();
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "serialize.hpp"
+
+using namespace Boinc;
+
+namespace
+{
+int failures = 0;
+
+void
+check(bool ok, const std::string& what)
+{
+  if (!ok)
+  {
+    std::cerr << "FAIL: " << what << std::endl;
+    failures++;
+  }
+}
+
+void
+check_output(const OutputBuffer& out, const std::string& expected, const std::string& what)
+{
+  std::string got(out.data(), out.size());
+  if (got != expected)
+  {
+    std::cerr << "FAIL: " << what << ": got [" << got << "], expected [" << expected << "]" << std::endl;
+    failures++;
+  }
+}
+
+void
+test_json_escaping()
+{
+  char storage[256];
+  OutputBuffer out(storage, sizeof(storage));
+  Message m;
+  m.msg_number = -7;
+  m.body = Glib::ustring("q\"b\\n\nr\rt\tc\x01\x1f");
+  check(write_json(out, m), "message fits");
+  check_output(out, "{\"msg_number\":-7,\"body\":\"q\\\"b\\\\n\\nr\\rt\\tc\\u0001\\u001f\"}", "JSON string escaping");
+}
+
+void
+test_json_non_finite()
+{
+  char storage[256];
+  OutputBuffer out(storage, sizeof(storage));
+  ProjectDiskUsage p;
+  p.master_url = Glib::ustring("https://example.org/");
+  p.disk_usage = std::numeric_limits<double>::quiet_NaN();
+  check(write_json(out, p), "record fits");
+  p.disk_usage = std::numeric_limits<double>::infinity();
+  check(write_json(out, p), "record fits");
+  p.disk_usage = 0.1;
+  check(write_json(out, p), "record fits");
+  check_output(out,
+    "{\"master_url\":\"https://example.org/\",\"disk_usage\":null}"
+    "{\"master_url\":\"https://example.org/\",\"disk_usage\":null}"
+    "{\"master_url\":\"https://example.org/\",\"disk_usage\":0.1}",
+    "JSON non-finite reals");
+}
+
+void
+test_line_protocol()
+{
+  char storage[256];
+  OutputBuffer out(storage, sizeof(storage));
+  Message m;
+  m.priority = 2;
+  m.body = Glib::ustring("say \"hi\" \\ bye\nnext");
+  check(write_line_protocol(out, "boinc messages,x", m, "host=a", 1500000000000000000), "line fits");
+  check_output(out, "boinc\\ messages\\,x,host=a priority=2i,body=\"say \\\"hi\\\" \\\\ bye\\nnext\" 1500000000000000000\n", "line protocol escaping");
+
+  out.clear();
+  ProjectDiskUsage p;
+  p.disk_usage = std::numeric_limits<double>::infinity();
+  check(write_line_protocol(out, "disk", p), "record without representable fields");
+  check(out.size() == 0, "record without representable fields writes no line");
+  p.master_url = Glib::ustring("u");
+  check(write_line_protocol(out, "disk", p), "line fits");
+  check_output(out, "disk master_url=\"u\"\n", "non-finite field is skipped");
+}
+
+void
+test_disk_usage_projects()
+{
+  char storage[512];
+  OutputBuffer out(storage, sizeof(storage));
+  DiskUsage usage;
+  usage.d_total = 10;
+  ProjectDiskUsage p;
+  p.master_url = Glib::ustring("https://a.org/x y,z=1");
+  p.disk_usage = 2.5;
+  usage.projects.push_back(p);
+  p.master_url = Glib::ustring("https://b.org/");
+  p.disk_usage = std::numeric_limits<double>::quiet_NaN();
+  usage.projects.push_back(p);
+
+  check(write_json(out, usage), "disk usage fits");
+  check_output(out, "{\"d_total\":10,\"projects\":[{\"master_url\":\"https://a.org/x y,z=1\",\"disk_usage\":2.5},{\"master_url\":\"https://b.org/\",\"disk_usage\":null}]}",
+    "JSON disk usage projects");
+
+  out.clear();
+  check(write_line_protocol(out, "disk", usage, "host=a", 7), "disk usage lines fit");
+  check_output(out, "disk,host=a d_total=10 7\ndisk,host=a,project=https://a.org/x\\ y\\,z\\=1 disk_usage=2.5 7\n", "line protocol disk usage projects");
+}
+
+void
+test_overflow_rolls_back()
+{
+  char storage[40];
+  OutputBuffer out(storage, sizeof(storage));
+  out.put("prefix", 6);
+
+  Message m;
+  m.body = Glib::ustring(std::string(64, 'x'));
+  check(!write_json(out, m), "oversized JSON record reports overflow");
+  check_output(out, "prefix", "oversized JSON record is rolled back");
+  check(!out.overflowed(), "rollback clears the overflow flag");
+
+  check(!write_line_protocol(out, "m", m), "oversized line reports overflow");
+  check_output(out, "prefix", "oversized line is rolled back");
+  check(!out.overflowed(), "rollback clears the overflow flag");
+
+  Message small;
+  small.priority = 1;
+  check(write_json(out, small), "record fits after a rollback");
+  check_output(out, "prefix{\"priority\":1}", "record after a rollback");
+}
+}
+
+int
+main()
+{
+  test_json_escaping();
+  test_json_non_finite();
+  test_line_protocol();
+  test_disk_usage_projects();
+  test_overflow_rolls_back();
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}